@@ -0,0 +1,6 @@
+#pragma once
+
+struct AdaptiveExecutionPolicy {
+};
+
+inline constexpr AdaptiveExecutionPolicy adaptive_execution;
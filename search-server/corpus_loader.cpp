@@ -0,0 +1,123 @@
+#include <charconv>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include "corpus_loader.h"
+#include "mapped_file.h"
+
+namespace {
+
+const size_t CORPUS_CHUNK_SIZE = 8 << 20;
+
+struct ParsedDocument {
+    int id;
+    DocumentStatus status;
+    std::vector<int> ratings;
+    std::vector<std::string_view> words;
+};
+
+[[noreturn]] void ThrowMalformedLine(size_t offset, std::string_view reason) {
+    using namespace std::literals;
+    throw std::invalid_argument("Malformed corpus line at byte "s + std::to_string(offset) + ": "s + std::string(reason));
+}
+
+std::string_view CutField(std::string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == std::string_view::npos) {
+        return {};
+    }
+    const std::string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+bool ParseInt(std::string_view text, int& value) {
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+bool ParseStatus(std::string_view text, DocumentStatus& status) {
+    static const std::string_view status_names[] = { "ACTUAL", "IRRELEVANT", "BANNED", "REMOVED" };
+    for (int i = 0; i < DOCUMENT_STATUS_COUNT; ++i) {
+        if (text == status_names[i] || (text.size() == 1 && text[0] == '0' + i)) {
+            status = static_cast<DocumentStatus>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+ParsedDocument ParseLine(std::string_view line, size_t offset) {
+    ParsedDocument document;
+    const std::string_view id_field = CutField(line);
+    const std::string_view status_field = CutField(line);
+    const std::string_view ratings_field = CutField(line);
+    if (!ParseInt(id_field, document.id)) {
+        ThrowMalformedLine(offset, "bad document id");
+    }
+    if (!ParseStatus(status_field, document.status)) {
+        ThrowMalformedLine(offset, "bad document status");
+    }
+    for (std::string_view rating_text : SplitIntoWordsView(ratings_field)) {
+        int rating;
+        if (!ParseInt(rating_text, rating)) {
+            ThrowMalformedLine(offset, "bad rating");
+        }
+        document.ratings.push_back(rating);
+    }
+    document.words = SplitIntoWordsView(line);
+    return document;
+}
+
+std::vector<ParsedDocument> ParseChunk(std::string_view chunk, size_t chunk_offset) {
+    std::vector<ParsedDocument> documents;
+    size_t line_offset = 0;
+    while (line_offset < chunk.size()) {
+        const size_t line_end = std::min(chunk.find('\n', line_offset), chunk.size());
+        std::string_view line = chunk.substr(line_offset, line_end - line_offset);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            documents.push_back(ParseLine(line, chunk_offset + line_offset));
+        }
+        line_offset = line_end + 1;
+    }
+    return documents;
+}
+
+}
+
+size_t LoadCorpus(SearchServer& search_server, const std::string& path) {
+    const MappedFile file(path);
+    const std::string_view data = file.GetData();
+    const size_t max_pending_chunks = std::max(2u, std::thread::hardware_concurrency());
+
+    std::deque<std::future<std::vector<ParsedDocument>>> pending_chunks;
+    size_t offset = 0;
+    const auto schedule_chunk = [&file, data, &offset, &pending_chunks] {
+        const size_t newline = data.find('\n', std::min(offset + CORPUS_CHUNK_SIZE, data.size()));
+        const size_t chunk_end = newline == std::string_view::npos ? data.size() : newline + 1;
+        file.Prefetch(chunk_end, CORPUS_CHUNK_SIZE);
+        pending_chunks.push_back(std::async(std::launch::async, ParseChunk, data.substr(offset, chunk_end - offset), offset));
+        offset = chunk_end;
+    };
+
+    while (offset < data.size() && pending_chunks.size() < max_pending_chunks) {
+        schedule_chunk();
+    }
+    size_t document_count = 0;
+    while (!pending_chunks.empty()) {
+        const auto documents = pending_chunks.front().get();
+        pending_chunks.pop_front();
+        if (offset < data.size()) {
+            schedule_chunk();
+        }
+        for (const ParsedDocument& document : documents) {
+            search_server.AddTokenizedDocument(document.id, document.words, document.status, document.ratings);
+        }
+        document_count += documents.size();
+    }
+    return document_count;
+}
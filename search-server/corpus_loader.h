@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+#include "search_server.h"
+
+// Loads documents from a file with one document per line:
+// id<TAB>status<TAB>ratings<TAB>text
+// status is a DocumentStatus name (ACTUAL) or number (0), ratings are separated by spaces.
+size_t LoadCorpus(SearchServer& search_server, const std::string& path);
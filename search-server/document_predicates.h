@@ -0,0 +1,25 @@
+#pragma once
+#include "document.h"
+
+struct AnyDocumentPredicate {
+    bool operator()(int document_id, DocumentStatus status, int rating) const {
+        return true;
+    }
+};
+
+struct DocumentStatusPredicate {
+    DocumentStatus status;
+
+    bool operator()(int document_id, DocumentStatus document_status, int rating) const {
+        return document_status == status;
+    }
+};
+
+struct DocumentRatingPredicate {
+    int min_rating;
+    int max_rating;
+
+    bool operator()(int document_id, DocumentStatus status, int rating) const {
+        return min_rating <= rating && rating <= max_rating;
+    }
+};
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include "document_store.h"
+
+namespace {
+
+// The dense range may grow to this many ids or twice the document count, whichever is larger.
+const size_t MIN_DENSE_ID_COUNT = 1024;
+
+}
+
+int DocumentStore::AddDocument(int document_id, int rating, DocumentStatus status, int length) {
+    const int slot = AllocateSlot();
+    ids_[slot] = document_id;
+    ratings_[slot] = rating;
+    lengths_[slot] = length;
+    total_length_ += length;
+    statuses_[slot] = status;
+    status_bits_[static_cast<int>(status)][slot] = true;
+
+    SetSlot(document_id, slot);
+    ++document_count_;
+    return slot;
+}
+
+std::vector<int> DocumentStore::RemoveDocuments(std::vector<int> document_ids) {
+    std::sort(document_ids.begin(), document_ids.end());
+    document_ids.erase(std::unique(document_ids.begin(), document_ids.end()), document_ids.end());
+    std::vector<int> removed_slots;
+    removed_slots.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        const int slot = FindSlot(document_id);
+        if (slot < 0) {
+            continue;
+        }
+        status_bits_[static_cast<int>(statuses_[slot])][slot] = false;
+        total_length_ -= lengths_[slot];
+        free_slots_.push_back(slot);
+        removed_slots.push_back(slot);
+        if (static_cast<size_t>(document_id) < dense_id_to_slot_.size()) {
+            dense_id_to_slot_[document_id] = -1;
+        }
+        else {
+            sparse_id_to_slot_.erase(document_id);
+        }
+        --document_count_;
+    }
+    return removed_slots;
+}
+
+int DocumentStore::FindSlot(int document_id) const {
+    if (document_id >= 0 && static_cast<size_t>(document_id) < dense_id_to_slot_.size()) {
+        return dense_id_to_slot_[document_id];
+    }
+    const auto it = sparse_id_to_slot_.find(document_id);
+    return it == sparse_id_to_slot_.end() ? -1 : it->second;
+}
+
+bool DocumentStore::Contains(int document_id) const {
+    return FindSlot(document_id) >= 0;
+}
+
+int DocumentStore::GetDocumentCount() const {
+    return document_count_;
+}
+
+double DocumentStore::GetAverageDocumentLength() const {
+    if (document_count_ == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(total_length_) / document_count_;
+}
+
+int DocumentStore::AllocateSlot() {
+    if (!free_slots_.empty()) {
+        const int slot = free_slots_.back();
+        free_slots_.pop_back();
+        return slot;
+    }
+    const int slot = static_cast<int>(ids_.size());
+    ids_.push_back(0);
+    ratings_.push_back(0);
+    lengths_.push_back(0);
+    statuses_.push_back(DocumentStatus::ACTUAL);
+    for (auto& bits : status_bits_) {
+        bits.push_back(false);
+    }
+    return slot;
+}
+
+void DocumentStore::SetSlot(int document_id, int slot) {
+    const size_t id = static_cast<size_t>(document_id);
+    if (id < dense_id_to_slot_.size()) {
+        dense_id_to_slot_[id] = slot;
+        return;
+    }
+    if (id >= std::max(MIN_DENSE_ID_COUNT, 2 * static_cast<size_t>(document_count_ + 1))) {
+        sparse_id_to_slot_.emplace(document_id, slot);
+        return;
+    }
+    dense_id_to_slot_.resize(id + 1, -1);
+    dense_id_to_slot_[id] = slot;
+    // Sparse ids now covered by the dense range move into it.
+    auto it = sparse_id_to_slot_.begin();
+    for (; it != sparse_id_to_slot_.end() && static_cast<size_t>(it->first) <= id; ++it) {
+        dense_id_to_slot_[it->first] = it->second;
+    }
+    sparse_id_to_slot_.erase(sparse_id_to_slot_.begin(), it);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "document.h"
+
+const int DOCUMENT_STATUS_COUNT = 4;
+
+class DocumentStore {
+public:
+    // Yields document ids in ascending order.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        Iterator(const DocumentStore* store, size_t dense_id, std::map<int, int>::const_iterator sparse_it)
+            : store_(store)
+            , dense_id_(dense_id)
+            , sparse_it_(sparse_it) {
+            SkipAbsentIds();
+        }
+
+        int operator*() const {
+            return dense_id_ < store_->dense_id_to_slot_.size() ? static_cast<int>(dense_id_) : sparse_it_->first;
+        }
+
+        Iterator& operator++() {
+            if (dense_id_ < store_->dense_id_to_slot_.size()) {
+                ++dense_id_;
+                SkipAbsentIds();
+            }
+            else {
+                ++sparse_it_;
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return dense_id_ == other.dense_id_ && sparse_it_ == other.sparse_it_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const DocumentStore* store_;
+        size_t dense_id_;
+        std::map<int, int>::const_iterator sparse_it_;
+
+        void SkipAbsentIds() {
+            const auto& dense_id_to_slot = store_->dense_id_to_slot_;
+            while (dense_id_ < dense_id_to_slot.size() && dense_id_to_slot[dense_id_] < 0) {
+                ++dense_id_;
+            }
+        }
+    };
+
+    int AddDocument(int document_id, int rating, DocumentStatus status, int length);
+
+    // Returns the slots of removed documents in ascending order of their ids.
+    std::vector<int> RemoveDocuments(std::vector<int> document_ids);
+
+    int FindSlot(int document_id) const;
+
+    bool Contains(int document_id) const;
+
+    int GetDocumentCount() const;
+
+    int GetSlotCount() const {
+        return static_cast<int>(ids_.size());
+    }
+
+    double GetAverageDocumentLength() const;
+
+    int64_t GetTotalDocumentLength() const {
+        return total_length_;
+    }
+
+    int GetDocumentId(int slot) const {
+        return ids_[slot];
+    }
+
+    int GetRating(int slot) const {
+        return ratings_[slot];
+    }
+
+    int GetLength(int slot) const {
+        return lengths_[slot];
+    }
+
+    DocumentStatus GetStatus(int slot) const {
+        return statuses_[slot];
+    }
+
+    bool HasStatus(int slot, DocumentStatus status) const {
+        return status_bits_[static_cast<int>(status)][slot];
+    }
+
+    Iterator begin() const {
+        return Iterator(this, 0, sparse_id_to_slot_.begin());
+    }
+
+    Iterator end() const {
+        return Iterator(this, dense_id_to_slot_.size(), sparse_id_to_slot_.end());
+    }
+
+private:
+    // Slot by document id, -1 for absent ids. An id that would stretch this far beyond the
+    // document count goes to sparse_id_to_slot_ instead, so sparse ids are all above the dense range.
+    std::vector<int> dense_id_to_slot_;
+    std::map<int, int> sparse_id_to_slot_;
+    int document_count_ = 0;
+    std::vector<int> ids_;
+    std::vector<int> ratings_;
+    std::vector<int> lengths_;
+    int64_t total_length_ = 0;
+    std::vector<DocumentStatus> statuses_;
+    std::array<std::vector<bool>, DOCUMENT_STATUS_COUNT> status_bits_;
+    std::vector<int> free_slots_;
+
+    int AllocateSlot();
+
+    void SetSlot(int document_id, int slot);
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+struct IndexOptions {
+    bool store_positions = false;
+    bool index_fuzzy_terms = false;
+};
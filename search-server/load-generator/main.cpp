@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../query-server/query_client.h"
+#include "../query_generators.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace {
+
+struct ClientResult {
+    vector<Clock::duration> latencies;
+    int error_count = 0;
+};
+
+// Keeps up to depth requests in flight on one connection.
+ClientResult RunClient(const Endpoint& endpoint, const vector<string>& queries, size_t begin, size_t end, size_t depth) {
+    QueryClient client(endpoint);
+    ClientResult result;
+    result.latencies.reserve(end - begin);
+    vector<Clock::time_point> send_times;
+    send_times.reserve(end - begin);
+    size_t next_query = begin;
+    size_t in_flight = 0;
+    while (next_query < end || in_flight > 0) {
+        while (next_query < end && in_flight < depth) {
+            const uint32_t request_id = client.SendFindTopDocuments(queries[next_query++]);
+            send_times.resize(request_id + 1);
+            send_times[request_id] = Clock::now();
+            ++in_flight;
+        }
+        const QueryResponse response = client.ReceiveResponse();
+        result.latencies.push_back(Clock::now() - send_times[response.request_id]);
+        if (response.code != ResponseCode::OK) {
+            ++result.error_count;
+        }
+        --in_flight;
+    }
+    return result;
+}
+
+int UploadDocuments(const Endpoint& endpoint, const vector<string>& documents, size_t depth) {
+    QueryClient client(endpoint);
+    int error_count = 0;
+    size_t in_flight = 0;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        client.SendAddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        if (++in_flight == depth) {
+            error_count += client.ReceiveResponse().code != ResponseCode::OK;
+            --in_flight;
+        }
+    }
+    for (; in_flight > 0; --in_flight) {
+        error_count += client.ReceiveResponse().code != ResponseCode::OK;
+    }
+    return error_count;
+}
+
+double ToMicroseconds(Clock::duration duration) {
+    return chrono::duration<double, micro>(duration).count();
+}
+
+}
+
+// Arguments are key=value pairs:
+//   endpoint=/tmp/search-server.sock  connections=4  depth=16
+//   queries=100000  words=10  documents=0 (documents to upload before the run)
+int main(int argc, char* argv[]) {
+    string endpoint_text = "/tmp/search-server.sock"s;
+    size_t connection_count = 4;
+    size_t depth = 16;
+    size_t query_count = 100'000;
+    int max_word_count = 10;
+    size_t document_count = 0;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t equals = argument.find('=');
+        const string_view key = argument.substr(0, equals);
+        const string value(equals == string_view::npos ? string_view() : argument.substr(equals + 1));
+        if (key == "endpoint"sv) {
+            endpoint_text = value;
+        }
+        else if (key == "connections"sv) {
+            connection_count = max<size_t>(stoul(value), 1);
+        }
+        else if (key == "depth"sv) {
+            depth = max<size_t>(stoul(value), 1);
+        }
+        else if (key == "queries"sv) {
+            query_count = stoul(value);
+        }
+        else if (key == "words"sv) {
+            max_word_count = stoi(value);
+        }
+        else if (key == "documents"sv) {
+            document_count = stoul(value);
+        }
+        else {
+            cerr << "Unknown argument: "s << argument << endl;
+            return 1;
+        }
+    }
+
+    try {
+        const Endpoint endpoint = Endpoint::Parse(endpoint_text);
+        mt19937 generator;
+        const auto dictionary = GenerateDictionary(generator, 1000, 10);
+        if (document_count > 0) {
+            const auto documents = GenerateQueries(generator, dictionary, static_cast<int>(document_count), 70);
+            const auto start = Clock::now();
+            const int error_count = UploadDocuments(endpoint, documents, depth);
+            cout << "Uploaded "s << document_count - error_count << " documents in "s
+                << chrono::duration_cast<chrono::milliseconds>(Clock::now() - start).count() << " ms"s;
+            if (error_count > 0) {
+                cout << ", "s << error_count << " rejected"s;
+            }
+            cout << endl;
+        }
+        const auto queries = GenerateQueries(generator, dictionary, static_cast<int>(query_count), max_word_count);
+
+        vector<ClientResult> results(connection_count);
+        vector<thread> clients;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < connection_count; ++i) {
+            clients.emplace_back([&, i] {
+                results[i] = RunClient(endpoint, queries, query_count * i / connection_count, query_count * (i + 1) / connection_count, depth);
+                });
+        }
+        for (thread& client : clients) {
+            client.join();
+        }
+        const auto elapsed = Clock::now() - start;
+
+        vector<Clock::duration> latencies;
+        latencies.reserve(query_count);
+        int error_count = 0;
+        for (const ClientResult& result : results) {
+            latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+            error_count += result.error_count;
+        }
+        if (latencies.empty()) {
+            return 0;
+        }
+        sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double fraction) {
+            return ToMicroseconds(latencies[min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()))]);
+        };
+        cout << latencies.size() << " queries over "s << connection_count << " connections, depth "s << depth
+            << ": "s << latencies.size() / chrono::duration<double>(elapsed).count() << " QPS"s << endl;
+        cout << "latency us: p50 "s << percentile(0.5) << ", p90 "s << percentile(0.9) << ", p99 "s << percentile(0.99)
+            << ", p99.9 "s << percentile(0.999) << ", max "s << ToMicroseconds(latencies.back()) << endl;
+        cout << "errors: "s << error_count << endl;
+    }
+    catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
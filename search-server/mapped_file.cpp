@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <system_error>
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    using namespace std::literals;
+    file_handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE) {
+        file_handle_ = nullptr;
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot open "s + path);
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle_, &file_size)) {
+        const int error = static_cast<int>(GetLastError());
+        CloseHandle(file_handle_);
+        throw std::system_error(error, std::system_category(), "Cannot get size of "s + path);
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    if (size_ == 0) {
+        return;
+    }
+    mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle_ != nullptr) {
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (data_ == nullptr) {
+        const int error = static_cast<int>(GetLastError());
+        if (mapping_handle_ != nullptr) {
+            CloseHandle(mapping_handle_);
+        }
+        CloseHandle(file_handle_);
+        throw std::system_error(error, std::system_category(), "Cannot map "s + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_ != nullptr) {
+        CloseHandle(mapping_handle_);
+    }
+    CloseHandle(file_handle_);
+}
+
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+    if (offset >= size_) {
+        return;
+    }
+    WIN32_MEMORY_RANGE_ENTRY range{ const_cast<char*>(data_ + offset), std::min(length, size_ - offset) };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    using namespace std::literals;
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot open "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot get size of "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ == 0) {
+        close(fd);
+        return;
+    }
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), "Cannot map "s + path);
+    }
+    data_ = static_cast<const char*>(data);
+    madvise(data, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+    if (offset >= size_) {
+        return;
+    }
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t aligned_offset = offset / page_size * page_size;
+    const size_t end = offset + std::min(length, size_ - offset);
+    madvise(const_cast<char*>(data_ + aligned_offset), end - aligned_offset, MADV_WILLNEED);
+}
+#endif
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include "numa_search_server.h"
+#include "process_queries.h"
+
+NumaSearchServer::NumaSearchServer(std::shared_ptr<const SearchServer> search_server)
+    : NumaSearchServer(std::move(search_server), DetectNumaNodes()) {
+}
+
+NumaSearchServer::NumaSearchServer(std::shared_ptr<const SearchServer> search_server, std::vector<NumaNode> nodes)
+    : nodes_(std::move(nodes)) {
+    using namespace std::literals;
+    if (nodes_.empty()) {
+        throw std::invalid_argument("NUMA search server needs at least one node"s);
+    }
+    if (!search_server) {
+        throw std::invalid_argument("NUMA search server needs a search server"s);
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        for (const int cpu : nodes_[i].cpus) {
+            if (cpu >= static_cast<int>(cpu_to_node_index_.size())) {
+                cpu_to_node_index_.resize(cpu + 1, -1);
+            }
+            cpu_to_node_index_[cpu] = static_cast<int>(i);
+        }
+    }
+    if (nodes_.size() == 1) {
+        replicas_.push_back(std::move(search_server));
+        return;
+    }
+    // Each replica is copied by a thread pinned to its node, so first-touch
+    // allocation places the replica's pages in that node's memory.
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        node_pools_.push_back(std::make_unique<ThreadPool>(GetWorkerCount(i), [cpus = nodes_[i].cpus] {
+            PinCurrentThread(cpus);
+            }));
+    }
+    std::vector<std::future<std::shared_ptr<const SearchServer>>> replica_futures;
+    replica_futures.reserve(nodes_.size());
+    for (const auto& pool : node_pools_) {
+        replica_futures.push_back(pool->Submit([&search_server] {
+            return std::shared_ptr<const SearchServer>(std::make_shared<SearchServer>(*search_server));
+            }));
+    }
+    for (auto& future : replica_futures) {
+        replicas_.push_back(future.get());
+    }
+}
+
+size_t NumaSearchServer::GetNodeCount() const {
+    return nodes_.size();
+}
+
+const SearchServer& NumaSearchServer::GetLocalReplica() const {
+    const int cpu = GetCurrentCpu();
+    if (cpu >= 0 && cpu < static_cast<int>(cpu_to_node_index_.size()) && cpu_to_node_index_[cpu] >= 0) {
+        return *replicas_[cpu_to_node_index_[cpu]];
+    }
+    return *replicas_.front();
+}
+
+std::vector<Document> NumaSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return GetLocalReplica().FindTopDocuments(raw_query);
+}
+
+std::vector<std::vector<Document>> NumaSearchServer::ProcessQueries(const std::vector<std::string>& queries) const {
+    if (replicas_.size() == 1) {
+        return ::ProcessQueries(*replicas_.front(), queries);
+    }
+    std::vector<std::vector<Document>> result(queries.size());
+    std::atomic<size_t> next_query = 0;
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        for (size_t j = 0; j < node_pools_[i]->GetThreadCount(); ++j) {
+            workers.push_back(node_pools_[i]->Submit([&replica = *replicas_[i], &queries, &result, &next_query] {
+                try {
+                    for (size_t query_index = next_query++; query_index < queries.size(); query_index = next_query++) {
+                        result[query_index] = replica.FindTopDocuments(queries[query_index]);
+                    }
+                }
+                catch (...) {
+                    next_query = queries.size();
+                    throw;
+                }
+                }));
+        }
+    }
+    // Workers refer to this call's locals, so all of them finish before an error propagates.
+    std::exception_ptr error;
+    for (auto& worker : workers) {
+        try {
+            worker.get();
+        }
+        catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
+size_t NumaSearchServer::GetWorkerCount(size_t node_index) const {
+    if (!nodes_[node_index].cpus.empty()) {
+        return nodes_[node_index].cpus.size();
+    }
+    return std::max(1u, std::thread::hardware_concurrency() / static_cast<unsigned>(nodes_.size()));
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "numa_topology.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+// Serves read-only queries from one replica of the index per NUMA node.
+// On a single node the source server is shared and nothing is copied.
+class NumaSearchServer {
+public:
+    explicit NumaSearchServer(std::shared_ptr<const SearchServer> search_server);
+
+    NumaSearchServer(std::shared_ptr<const SearchServer> search_server, std::vector<NumaNode> nodes);
+
+    size_t GetNodeCount() const;
+
+    const SearchServer& GetLocalReplica() const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::vector<std::vector<Document>> ProcessQueries(const std::vector<std::string>& queries) const;
+
+private:
+    std::vector<NumaNode> nodes_;
+    std::vector<int> cpu_to_node_index_;
+    std::vector<std::shared_ptr<const SearchServer>> replicas_;
+    // ProcessQueries workers pinned to each node's cpus; empty on a single node.
+    std::vector<std::unique_ptr<ThreadPool>> node_pools_;
+
+    size_t GetWorkerCount(size_t node_index) const;
+};
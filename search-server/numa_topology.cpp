@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "numa_topology.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+const std::string NODE_SYSFS_PATH = "/sys/devices/system/node/";
+
+std::optional<std::string> ReadFirstLine(const std::string& path) {
+    std::ifstream input(path);
+    std::string line;
+    if (!input || !std::getline(input, line)) {
+        return std::nullopt;
+    }
+    return line;
+}
+
+// Parses the kernel list format, e.g. "0-3,8-11".
+std::vector<int> ParseList(std::string_view text) {
+    std::vector<int> values;
+    while (!text.empty()) {
+        const size_t comma = text.find(',');
+        const std::string range(text.substr(0, comma));
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+        const size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int value = first; value <= last; ++value) {
+                values.push_back(value);
+            }
+        }
+        catch (const std::exception&) {
+            return {};
+        }
+    }
+    return values;
+}
+
+std::vector<int> GetAllowedCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+}
+
+std::vector<NumaNode> DetectNumaNodes() {
+    std::vector<NumaNode> nodes;
+    const auto allowed_cpus = GetAllowedCpus();
+    if (const auto online_nodes = ReadFirstLine(NODE_SYSFS_PATH + "online")) {
+        for (const int node_id : ParseList(*online_nodes)) {
+            const auto cpu_list = ReadFirstLine(NODE_SYSFS_PATH + "node" + std::to_string(node_id) + "/cpulist");
+            if (!cpu_list) {
+                continue;
+            }
+            NumaNode node{ node_id, {} };
+            for (const int cpu : ParseList(*cpu_list)) {
+                if (std::binary_search(allowed_cpus.begin(), allowed_cpus.end(), cpu)) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            // Memory-only nodes and nodes outside our cpuset have nobody to serve.
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+    }
+    if (nodes.empty()) {
+        nodes.push_back({ 0, {} });
+    }
+    return nodes;
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+int GetCurrentCpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// Reads the topology from sysfs. Without it, returns a single node with no known cpus.
+std::vector<NumaNode> DetectNumaNodes();
+
+bool PinCurrentThread(const std::vector<int>& cpus);
+
+int GetCurrentCpu();
@@ -3,6 +3,10 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <cassert>
 
 template <typename Iterator>
@@ -73,4 +77,90 @@ private:
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
+}
+
+template <typename Cursor, typename PageFetcher>
+class CursorPaginator {
+public:
+    using Page = std::invoke_result_t<const PageFetcher&, const Cursor&>;
+    using PageRange = IteratorRange<typename decltype(Page::documents)::const_iterator>;
+
+    class PageIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = PageRange;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = PageRange;
+
+        PageIterator() = default;
+
+        PageIterator(const PageFetcher* fetcher, Page page)
+            : fetcher_(page.documents.empty() ? nullptr : fetcher)
+            , page_(std::move(page)) {
+        }
+
+        PageRange operator*() const {
+            return { page_.documents.begin(), page_.documents.end() };
+        }
+
+        PageIterator& operator++() {
+            if (page_.next_cursor) {
+                const Cursor cursor = *page_.next_cursor;
+                *this = PageIterator(fetcher_, (*fetcher_)(cursor));
+            }
+            else {
+                *this = PageIterator();
+            }
+            return *this;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return fetcher_ == nullptr && other.fetcher_ == nullptr;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const PageFetcher* fetcher_ = nullptr;
+        Page page_;
+    };
+
+    explicit CursorPaginator(PageFetcher fetcher)
+        : fetcher_(std::move(fetcher)) {
+    }
+
+    PageIterator begin() const {
+        return PageIterator(&fetcher_, fetcher_(Cursor()));
+    }
+
+    PageIterator end() const {
+        return PageIterator();
+    }
+
+private:
+    PageFetcher fetcher_;
+};
+
+template <typename SearchServer, typename DocumentPredicate>
+auto PaginateSearch(const SearchServer& search_server, std::string_view raw_query, size_t page_size, DocumentPredicate document_predicate) {
+    assert(page_size > 0);
+    using Cursor = typename decltype(search_server.FindTopDocumentsPage(raw_query, page_size).next_cursor)::value_type;
+    // The query is copied: the paginator may outlive the caller's string.
+    auto fetcher = [&search_server, raw_query = std::string(raw_query), page_size, document_predicate](const Cursor& cursor) {
+        return search_server.FindTopDocumentsPage(raw_query, document_predicate, page_size, cursor);
+    };
+    return CursorPaginator<Cursor, decltype(fetcher)>(std::move(fetcher));
+}
+
+template <typename SearchServer>
+auto PaginateSearch(const SearchServer& search_server, std::string_view raw_query, size_t page_size) {
+    assert(page_size > 0);
+    using Cursor = typename decltype(search_server.FindTopDocumentsPage(raw_query, page_size).next_cursor)::value_type;
+    auto fetcher = [&search_server, raw_query = std::string(raw_query), page_size](const Cursor& cursor) {
+        return search_server.FindTopDocumentsPage(raw_query, page_size, cursor);
+    };
+    return CursorPaginator<Cursor, decltype(fetcher)>(std::move(fetcher));
 }
\ No newline at end of file
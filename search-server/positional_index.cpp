@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <iterator>
+#include "positional_index.h"
+
+namespace {
+
+void AppendVarint(std::vector<uint8_t>& data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t*& it) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *it++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+}
+
+}
+
+void PositionalIndex::AddDocument(int slot, const std::vector<std::pair<int, int>>& term_positions) {
+    if (documents_.size() <= static_cast<size_t>(slot)) {
+        documents_.resize(slot + 1);
+    }
+    DocumentPositions& document = documents_[slot];
+    document = {};
+    int previous_position = -1;
+    for (const auto& [term_id, position] : term_positions) {
+        if (document.term_ids.empty() || document.term_ids.back() != term_id) {
+            document.term_ids.push_back(term_id);
+            document.offsets.push_back(static_cast<uint32_t>(document.data.size()));
+            previous_position = -1;
+        }
+        AppendVarint(document.data, static_cast<uint32_t>(position - previous_position));
+        previous_position = position;
+    }
+    document.offsets.push_back(static_cast<uint32_t>(document.data.size()));
+    document.term_ids.shrink_to_fit();
+    document.offsets.shrink_to_fit();
+    document.data.shrink_to_fit();
+}
+
+void PositionalIndex::RemoveDocument(int slot) {
+    if (static_cast<size_t>(slot) < documents_.size()) {
+        documents_[slot] = {};
+    }
+}
+
+bool PositionalIndex::HasTerm(int slot, int term_id) const {
+    const DocumentPositions* document = FindDocument(slot);
+    return document && std::binary_search(document->term_ids.begin(), document->term_ids.end(), term_id);
+}
+
+void PositionalIndex::DecodePositions(int slot, int term_id, std::vector<int>& positions) const {
+    positions.clear();
+    const DocumentPositions* document = FindDocument(slot);
+    if (!document) {
+        return;
+    }
+    const auto it = std::lower_bound(document->term_ids.begin(), document->term_ids.end(), term_id);
+    if (it == document->term_ids.end() || *it != term_id) {
+        return;
+    }
+    const auto index = std::distance(document->term_ids.begin(), it);
+    const uint8_t* data = document->data.data() + document->offsets[index];
+    const uint8_t* data_end = document->data.data() + document->offsets[index + 1];
+    int position = -1;
+    while (data != data_end) {
+        position += static_cast<int>(ReadVarint(data));
+        positions.push_back(position);
+    }
+}
+
+const PositionalIndex::DocumentPositions* PositionalIndex::FindDocument(int slot) const {
+    if (static_cast<size_t>(slot) >= documents_.size()) {
+        return nullptr;
+    }
+    return &documents_[slot];
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class PositionalIndex {
+public:
+    // term_positions must be sorted by term id, then by position.
+    void AddDocument(int slot, const std::vector<std::pair<int, int>>& term_positions);
+
+    void RemoveDocument(int slot);
+
+    bool HasTerm(int slot, int term_id) const;
+
+    void DecodePositions(int slot, int term_id, std::vector<int>& positions) const;
+
+private:
+    struct DocumentPositions {
+        std::vector<int> term_ids;
+        std::vector<uint32_t> offsets;
+        std::vector<uint8_t> data;
+    };
+    std::vector<DocumentPositions> documents_;
+
+    const DocumentPositions* FindDocument(int slot) const;
+};
@@ -0,0 +1,144 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "endpoint.h"
+
+namespace {
+
+const int LISTEN_BACKLOG = 512;
+
+[[noreturn]] void ThrowSystemError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+sockaddr_un MakeUnixAddress(const std::string& path) {
+    using namespace std::literals;
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Unix socket path is too long: "s + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+sockaddr_in MakeLoopbackAddress(uint16_t port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+}
+
+Endpoint Endpoint::Parse(std::string_view text) {
+    using namespace std::literals;
+    Endpoint endpoint;
+    if (!text.empty() && text[0] == '/') {
+        endpoint.unix_path = std::string(text);
+        return endpoint;
+    }
+    const size_t colon = text.rfind(':');
+    const std::string_view host = colon == std::string_view::npos ? std::string_view() : text.substr(0, colon);
+    if (!host.empty() && host != "127.0.0.1"sv && host != "localhost"sv) {
+        throw std::invalid_argument("Only loopback endpoints are supported: "s + std::string(text));
+    }
+    try {
+        const int port = std::stoi(std::string(text.substr(colon == std::string_view::npos ? 0 : colon + 1)));
+        if (port < 0 || port > 65535) {
+            throw std::out_of_range("port");
+        }
+        endpoint.port = static_cast<uint16_t>(port);
+    }
+    catch (const std::logic_error&) {
+        throw std::invalid_argument("Invalid endpoint: "s + std::string(text));
+    }
+    return endpoint;
+}
+
+int ListenOn(const Endpoint& endpoint) {
+    using namespace std::literals;
+    const bool is_unix = !endpoint.unix_path.empty();
+    const int fd = socket(is_unix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ThrowSystemError("socket"s);
+    }
+    int bind_result;
+    if (is_unix) {
+        const sockaddr_un address = MakeUnixAddress(endpoint.unix_path);
+        if (!RemoveSocketFile(endpoint.unix_path)) {
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot replace "s + endpoint.unix_path);
+        }
+        bind_result = bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    }
+    else {
+        const int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        const sockaddr_in address = MakeLoopbackAddress(endpoint.port);
+        bind_result = bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    }
+    if (bind_result != 0 || listen(fd, LISTEN_BACKLOG) != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot listen on endpoint"s);
+    }
+    return fd;
+}
+
+bool RemoveSocketFile(const std::string& path) {
+    struct stat status;
+    if (lstat(path.c_str(), &status) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+        errno = ENOTSOCK;
+        return false;
+    }
+    return unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+int ConnectTo(const Endpoint& endpoint) {
+    using namespace std::literals;
+    const bool is_unix = !endpoint.unix_path.empty();
+    const int fd = socket(is_unix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ThrowSystemError("socket"s);
+    }
+    int connect_result;
+    if (is_unix) {
+        const sockaddr_un address = MakeUnixAddress(endpoint.unix_path);
+        connect_result = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    }
+    else {
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        const sockaddr_in address = MakeLoopbackAddress(endpoint.port);
+        connect_result = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    }
+    if (connect_result != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot connect to endpoint"s);
+    }
+    return fd;
+}
+
+uint16_t GetListeningPort(int socket_fd) {
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (getsockname(socket_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0 || address.sin_family != AF_INET) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Either a Unix socket path ("/tmp/search.sock") or a loopback TCP port ("127.0.0.1:7000").
+struct Endpoint {
+    std::string unix_path;
+    uint16_t port = 0;
+
+    static Endpoint Parse(std::string_view text);
+};
+
+int ListenOn(const Endpoint& endpoint);
+
+// Removes a Unix socket left at path. Returns false and sets errno, leaving
+// the file alone, if something other than a socket is there.
+bool RemoveSocketFile(const std::string& path);
+
+int ConnectTo(const Endpoint& endpoint);
+
+uint16_t GetListeningPort(int socket_fd);
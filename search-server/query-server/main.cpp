@@ -0,0 +1,80 @@
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "../corpus_loader.h"
+#include "../search_server.h"
+#include "query_server.h"
+
+using namespace std;
+
+namespace {
+
+QueryServer* running_server = nullptr;
+
+void StopServer(int) {
+    if (running_server) {
+        running_server->Stop();
+    }
+}
+
+}
+
+// Arguments are key=value pairs:
+//   endpoint=/tmp/search-server.sock | endpoint=127.0.0.1:7000
+//   workers=N  corpus=path  stop_words="and with"
+int main(int argc, char* argv[]) {
+    string endpoint_text = "/tmp/search-server.sock"s;
+    size_t worker_count = max(1u, thread::hardware_concurrency());
+    string corpus_path;
+    string stop_words;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t equals = argument.find('=');
+        const string_view key = argument.substr(0, equals);
+        const string value(equals == string_view::npos ? string_view() : argument.substr(equals + 1));
+        if (key == "endpoint"sv) {
+            endpoint_text = value;
+        }
+        else if (key == "workers"sv) {
+            worker_count = stoul(value);
+        }
+        else if (key == "corpus"sv) {
+            corpus_path = value;
+        }
+        else if (key == "stop_words"sv) {
+            stop_words = value;
+        }
+        else {
+            cerr << "Unknown argument: "s << argument << endl;
+            return 1;
+        }
+    }
+
+    try {
+        SearchServer search_server(stop_words);
+        if (!corpus_path.empty()) {
+            cerr << "Loaded "s << LoadCorpus(search_server, corpus_path) << " documents"s << endl;
+        }
+        const Endpoint endpoint = Endpoint::Parse(endpoint_text);
+        QueryServer query_server(search_server, endpoint, worker_count);
+        running_server = &query_server;
+        signal(SIGINT, StopServer);
+        signal(SIGTERM, StopServer);
+        if (endpoint.unix_path.empty()) {
+            cerr << "Listening on 127.0.0.1:"s << query_server.GetPort() << endl;
+        }
+        else {
+            cerr << "Listening on "s << endpoint.unix_path << endl;
+        }
+        query_server.Run();
+        running_server = nullptr;
+    }
+    catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include "protocol.h"
+
+void ClearPadding(std::vector<Document>& documents) {
+    static const auto is_field_byte = [] {
+        std::array<bool, sizeof(Document)> is_field_byte = {};
+        const auto mark_field = [&is_field_byte](size_t offset, size_t size) {
+            std::fill_n(is_field_byte.begin() + offset, size, true);
+        };
+        mark_field(offsetof(Document, id), sizeof(Document::id));
+        mark_field(offsetof(Document, relevance), sizeof(Document::relevance));
+        mark_field(offsetof(Document, rating), sizeof(Document::rating));
+        return is_field_byte;
+    }();
+    for (Document& document : documents) {
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(&document);
+        for (size_t i = 0; i < sizeof(Document); ++i) {
+            if (!is_field_byte[i]) {
+                bytes[i] = 0;
+            }
+        }
+    }
+}
+
+FrameWriter::FrameWriter(uint32_t request_id, uint8_t type_or_code) {
+    buffer_.resize(FRAME_LENGTH_SIZE);
+    Put(request_id);
+    Put(type_or_code);
+}
+
+void FrameWriter::PutString(std::string_view text) {
+    Put(static_cast<uint32_t>(text.size()));
+    buffer_.append(text);
+}
+
+std::string FrameWriter::Finish(size_t extra_size) {
+    const uint32_t body_size = static_cast<uint32_t>(buffer_.size() - FRAME_LENGTH_SIZE + extra_size);
+    std::memcpy(buffer_.data(), &body_size, sizeof(body_size));
+    return std::move(buffer_);
+}
+
+bool FrameReader::GetString(std::string_view& text) {
+    uint32_t size;
+    return Get(size) && GetBytes(size, text);
+}
+
+bool FrameReader::GetBytes(size_t size, std::string_view& bytes) {
+    if (body_.size() < size) {
+        return false;
+    }
+    bytes = body_.substr(0, size);
+    body_.remove_prefix(size);
+    return true;
+}
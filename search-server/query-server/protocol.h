@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "../document.h"
+
+// Every frame is a uint32 body length followed by the body:
+//   request:  uint32 request_id, uint8 RequestType, payload
+//   response: uint32 request_id, uint8 ResponseCode, payload
+// Integers use the host byte order and Document arrays are sent as raw
+// structs with zeroed padding, so both ends must be built for the same
+// platform. The server only listens on Unix sockets and loopback.
+//
+// Payloads:
+//   FIND_TOP_DOCUMENTS  request  uint8 status, string query
+//                       response uint32 count, Document[count]
+//   MATCH_DOCUMENT      request  int32 document_id, string query
+//                       response uint8 status, uint32 count, string[count]
+//   ADD_DOCUMENT        request  int32 document_id, uint8 status, uint32 count, int32 ratings[count], string text
+//   REMOVE_DOCUMENT     request  int32 document_id
+//   errors              response string message
+// where string is a uint32 length followed by the bytes.
+
+enum class RequestType : uint8_t {
+    FIND_TOP_DOCUMENTS = 1,
+    MATCH_DOCUMENT = 2,
+    ADD_DOCUMENT = 3,
+    REMOVE_DOCUMENT = 4,
+};
+
+enum class ResponseCode : uint8_t {
+    OK = 0,
+    INVALID_ARGUMENT = 1,
+    OUT_OF_RANGE = 2,
+    BAD_REQUEST = 3,
+    INTERNAL_ERROR = 4,
+};
+
+const size_t FRAME_LENGTH_SIZE = sizeof(uint32_t);
+const size_t FRAME_HEADER_SIZE = FRAME_LENGTH_SIZE + sizeof(uint32_t) + sizeof(uint8_t);
+const uint32_t MAX_FRAME_SIZE = 16 << 20;
+
+static_assert(std::is_trivially_copyable_v<Document>);
+
+// Zeroes the padding bytes of the documents, so sending them as raw bytes does not leak memory.
+void ClearPadding(std::vector<Document>& documents);
+
+class FrameWriter {
+public:
+    FrameWriter(uint32_t request_id, uint8_t type_or_code);
+
+    template <typename Value>
+    void Put(Value value) {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void PutString(std::string_view text);
+
+    // Sets the body length, counting extra_size bytes that will be sent after the buffer.
+    std::string Finish(size_t extra_size = 0);
+
+private:
+    std::string buffer_;
+};
+
+class FrameReader {
+public:
+    explicit FrameReader(std::string_view body)
+        : body_(body) {
+    }
+
+    template <typename Value>
+    bool Get(Value& value) {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        if (body_.size() < sizeof(value)) {
+            return false;
+        }
+        std::memcpy(&value, body_.data(), sizeof(value));
+        body_.remove_prefix(sizeof(value));
+        return true;
+    }
+
+    bool GetString(std::string_view& text);
+
+    bool GetBytes(size_t size, std::string_view& bytes);
+
+    bool IsEnd() const {
+        return body_.empty();
+    }
+
+private:
+    std::string_view body_;
+};
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "query_client.h"
+
+using namespace std::literals;
+
+QueryClient::QueryClient(const Endpoint& endpoint)
+    : fd_(ConnectTo(endpoint)) {
+}
+
+QueryClient::~QueryClient() {
+    close(fd_);
+}
+
+uint32_t QueryClient::SendFindTopDocuments(std::string_view raw_query, DocumentStatus status) {
+    const uint32_t request_id = next_request_id_++;
+    FrameWriter writer(request_id, static_cast<uint8_t>(RequestType::FIND_TOP_DOCUMENTS));
+    writer.Put(static_cast<uint8_t>(status));
+    writer.PutString(raw_query);
+    output_ += writer.Finish();
+    return request_id;
+}
+
+uint32_t QueryClient::SendMatchDocument(std::string_view raw_query, int document_id) {
+    const uint32_t request_id = next_request_id_++;
+    FrameWriter writer(request_id, static_cast<uint8_t>(RequestType::MATCH_DOCUMENT));
+    writer.Put(static_cast<int32_t>(document_id));
+    writer.PutString(raw_query);
+    output_ += writer.Finish();
+    return request_id;
+}
+
+uint32_t QueryClient::SendAddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    const uint32_t request_id = next_request_id_++;
+    FrameWriter writer(request_id, static_cast<uint8_t>(RequestType::ADD_DOCUMENT));
+    writer.Put(static_cast<int32_t>(document_id));
+    writer.Put(static_cast<uint8_t>(status));
+    writer.Put(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        writer.Put(static_cast<int32_t>(rating));
+    }
+    writer.PutString(document);
+    output_ += writer.Finish();
+    return request_id;
+}
+
+uint32_t QueryClient::SendRemoveDocument(int document_id) {
+    const uint32_t request_id = next_request_id_++;
+    FrameWriter writer(request_id, static_cast<uint8_t>(RequestType::REMOVE_DOCUMENT));
+    writer.Put(static_cast<int32_t>(document_id));
+    output_ += writer.Finish();
+    return request_id;
+}
+
+void QueryClient::Flush() {
+    size_t offset = 0;
+    while (offset < output_.size()) {
+        const ssize_t written = send(fd_, output_.data() + offset, output_.size() - offset, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot send request"s);
+        }
+        offset += static_cast<size_t>(written);
+    }
+    output_.clear();
+}
+
+QueryResponse QueryClient::ReceiveResponse() {
+    Flush();
+    while (true) {
+        if (input_.size() >= FRAME_LENGTH_SIZE) {
+            uint32_t body_size;
+            std::memcpy(&body_size, input_.data(), sizeof(body_size));
+            if (body_size < FRAME_HEADER_SIZE - FRAME_LENGTH_SIZE) {
+                throw std::runtime_error("Malformed response frame"s);
+            }
+            if (input_.size() - FRAME_LENGTH_SIZE >= body_size) {
+                FrameReader reader(std::string_view(input_).substr(FRAME_LENGTH_SIZE, body_size));
+                QueryResponse response;
+                uint8_t code;
+                reader.Get(response.request_id);
+                reader.Get(code);
+                response.code = static_cast<ResponseCode>(code);
+                response.payload = input_.substr(FRAME_HEADER_SIZE, body_size - (FRAME_HEADER_SIZE - FRAME_LENGTH_SIZE));
+                input_.erase(0, FRAME_LENGTH_SIZE + body_size);
+                return response;
+            }
+        }
+        const size_t offset = input_.size();
+        input_.resize(offset + (64 << 10));
+        const ssize_t read_size = recv(fd_, input_.data() + offset, input_.size() - offset, 0);
+        input_.resize(offset + (read_size > 0 ? read_size : 0));
+        if (read_size == 0) {
+            throw std::runtime_error("Connection closed by server"s);
+        }
+        if (read_size < 0 && errno != EINTR) {
+            throw std::system_error(errno, std::generic_category(), "Cannot receive response"s);
+        }
+    }
+}
+
+QueryResponse QueryClient::ReceiveChecked(uint32_t request_id) {
+    QueryResponse response = ReceiveResponse();
+    if (response.request_id != request_id) {
+        throw std::logic_error("Unexpected response, pipelined requests are outstanding"s);
+    }
+    CheckResponse(response);
+    return response;
+}
+
+std::vector<Document> QueryClient::FindTopDocuments(std::string_view raw_query, DocumentStatus status) {
+    return ParseDocuments(ReceiveChecked(SendFindTopDocuments(raw_query, status)));
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> QueryClient::MatchDocument(std::string_view raw_query, int document_id) {
+    return ParseMatchedWords(ReceiveChecked(SendMatchDocument(raw_query, document_id)));
+}
+
+void QueryClient::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    ReceiveChecked(SendAddDocument(document_id, document, status, ratings));
+}
+
+void QueryClient::RemoveDocument(int document_id) {
+    ReceiveChecked(SendRemoveDocument(document_id));
+}
+
+void CheckResponse(const QueryResponse& response) {
+    if (response.code == ResponseCode::OK) {
+        return;
+    }
+    FrameReader reader(response.payload);
+    std::string_view message;
+    reader.GetString(message);
+    switch (response.code) {
+    case ResponseCode::INVALID_ARGUMENT:
+        throw std::invalid_argument(std::string(message));
+    case ResponseCode::OUT_OF_RANGE:
+        throw std::out_of_range(std::string(message));
+    default:
+        throw std::runtime_error("Query server error: "s + std::string(message));
+    }
+}
+
+std::vector<Document> ParseDocuments(const QueryResponse& response) {
+    CheckResponse(response);
+    FrameReader reader(response.payload);
+    uint32_t count;
+    std::string_view bytes;
+    if (!reader.Get(count) || !reader.GetBytes(static_cast<size_t>(count) * sizeof(Document), bytes) || !reader.IsEnd()) {
+        throw std::runtime_error("Malformed FindTopDocuments response"s);
+    }
+    std::vector<Document> documents(count);
+    if (count > 0) {
+        std::memcpy(static_cast<void*>(documents.data()), bytes.data(), bytes.size());
+    }
+    return documents;
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ParseMatchedWords(const QueryResponse& response) {
+    CheckResponse(response);
+    FrameReader reader(response.payload);
+    uint8_t status;
+    uint32_t count;
+    if (!reader.Get(status) || !reader.Get(count)) {
+        throw std::runtime_error("Malformed MatchDocument response"s);
+    }
+    std::vector<std::string> words;
+    words.reserve(std::min<size_t>(count, response.payload.size()));
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view word;
+        if (!reader.GetString(word)) {
+            throw std::runtime_error("Malformed MatchDocument response"s);
+        }
+        words.emplace_back(word);
+    }
+    return { std::move(words), static_cast<DocumentStatus>(status) };
+}
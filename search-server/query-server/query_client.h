@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "../document.h"
+#include "endpoint.h"
+#include "protocol.h"
+
+struct QueryResponse {
+    uint32_t request_id;
+    ResponseCode code;
+    std::string payload;
+};
+
+// Blocking client. Send* calls only buffer a request and return its id, so
+// any number of requests can be pipelined before ReceiveResponse; responses
+// may arrive in a different order. The synchronous calls must not be mixed
+// with outstanding pipelined requests.
+class QueryClient {
+public:
+    explicit QueryClient(const Endpoint& endpoint);
+
+    QueryClient(const QueryClient&) = delete;
+
+    QueryClient& operator=(const QueryClient&) = delete;
+
+    ~QueryClient();
+
+    uint32_t SendFindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
+
+    uint32_t SendMatchDocument(std::string_view raw_query, int document_id);
+
+    uint32_t SendAddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    uint32_t SendRemoveDocument(int document_id);
+
+    void Flush();
+
+    // Flushes buffered requests and waits for the next response.
+    QueryResponse ReceiveResponse();
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
+
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+private:
+    int fd_;
+    uint32_t next_request_id_ = 0;
+    std::string output_;
+    std::string input_;
+
+    QueryResponse ReceiveChecked(uint32_t request_id);
+};
+
+// Throws std::invalid_argument or std::out_of_range the way SearchServer would, std::runtime_error otherwise.
+void CheckResponse(const QueryResponse& response);
+
+std::vector<Document> ParseDocuments(const QueryResponse& response);
+
+std::tuple<std::vector<std::string>, DocumentStatus> ParseMatchedWords(const QueryResponse& response);
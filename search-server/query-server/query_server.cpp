@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "query_server.h"
+
+namespace {
+
+const size_t READ_CHUNK_SIZE = 64 << 10;
+const int MAX_EPOLL_EVENTS = 128;
+// How long accepting stays paused after an error that retrying right away would repeat.
+const int ACCEPT_RETRY_DELAY_MS = 100;
+const int MAX_WRITE_IOVECS = std::min(IOV_MAX, 256);
+// A connection is not read while it has this many requests in flight or this much unsent output.
+const size_t MAX_PENDING_REQUESTS = 1024;
+const size_t MAX_PENDING_OUTPUT_SIZE = 4 << 20;
+
+std::string MakeErrorResponse(uint32_t request_id, ResponseCode code, std::string_view message) {
+    FrameWriter writer(request_id, static_cast<uint8_t>(code));
+    writer.PutString(message);
+    return writer.Finish();
+}
+
+bool ReadStatus(FrameReader& reader, DocumentStatus& status) {
+    uint8_t status_value;
+    if (!reader.Get(status_value) || status_value >= DOCUMENT_STATUS_COUNT) {
+        return false;
+    }
+    status = static_cast<DocumentStatus>(status_value);
+    return true;
+}
+
+}
+
+struct QueryServer::Connection {
+    int fd;
+    std::string input;
+    std::deque<OutgoingResponse> output;
+    // Bytes of output.front() that were already written.
+    size_t output_offset = 0;
+    size_t output_size = 0;
+    size_t pending_request_count = 0;
+    uint32_t events = EPOLLIN;
+    // The client shut down its side; requests already read are still answered.
+    bool is_read_closed = false;
+    bool is_closed = false;
+
+    bool IsBackedUp() const {
+        return pending_request_count >= MAX_PENDING_REQUESTS || output_size >= MAX_PENDING_OUTPUT_SIZE;
+    }
+
+    bool IsDone() const {
+        return is_read_closed && pending_request_count == 0 && output.empty();
+    }
+};
+
+QueryServer::QueryServer(SearchServer& search_server, const Endpoint& endpoint, size_t worker_count)
+    : search_server_(search_server)
+    , endpoint_(endpoint) {
+    using namespace std::literals;
+    listen_fd_ = ListenOn(endpoint_);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        const int error = errno;
+        for (int fd : { listen_fd_, epoll_fd_, wake_fd_ }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        if (!endpoint_.unix_path.empty()) {
+            RemoveSocketFile(endpoint_.unix_path);
+        }
+        throw std::system_error(error, std::generic_category(), "Cannot create event loop"s);
+    }
+    reserve_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    epoll_event listen_event{};
+    listen_event.events = EPOLLIN;
+    listen_event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event);
+    epoll_event wake_event{};
+    wake_event.events = EPOLLIN;
+    wake_event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake_event);
+
+    workers_.reserve(std::max<size_t>(worker_count, 1));
+    for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+        workers_.emplace_back([this] {
+            RunWorker();
+            });
+    }
+}
+
+QueryServer::~QueryServer() {
+    {
+        std::lock_guard guard(tasks_mutex_);
+        is_shutting_down_ = true;
+    }
+    tasks_condition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    for (const auto& [fd, connection] : connections_) {
+        close(fd);
+    }
+    connections_.clear();
+    for (int* fd : { &listen_fd_, &epoll_fd_, &wake_fd_, &reserve_fd_ }) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (!endpoint_.unix_path.empty()) {
+        RemoveSocketFile(endpoint_.unix_path);
+        endpoint_.unix_path.clear();
+    }
+}
+
+void QueryServer::Run() {
+    using namespace std::literals;
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (!is_stopping_) {
+        const int event_count = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, is_accept_paused_ ? ACCEPT_RETRY_DELAY_MS : -1);
+        if (event_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "epoll_wait"s);
+        }
+        if (is_accept_paused_ && std::chrono::steady_clock::now() >= accept_resume_time_) {
+            SetAcceptPaused(false);
+        }
+        for (int i = 0; i < event_count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                AcceptConnections();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                uint64_t wake_count;
+                while (read(wake_fd_, &wake_count, sizeof(wake_count)) > 0) {
+                }
+                DrainCompletions();
+                continue;
+            }
+            const auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            const auto connection = it->second;
+            const uint32_t ready_events = events[i].events;
+            if (ready_events & EPOLLOUT) {
+                WriteTo(connection);
+            }
+            if (connection->is_closed) {
+                continue;
+            }
+            if ((connection->events & EPOLLIN) && (ready_events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                ReadFrom(connection);
+            }
+            else if (ready_events & (EPOLLHUP | EPOLLERR)) {
+                CloseConnection(connection);
+            }
+        }
+    }
+    is_stopping_ = false;
+}
+
+void QueryServer::Stop() {
+    is_stopping_ = true;
+    const uint64_t wake_count = 1;
+    [[maybe_unused]] const ssize_t written = write(wake_fd_, &wake_count, sizeof(wake_count));
+}
+
+uint16_t QueryServer::GetPort() const {
+    return GetListeningPort(listen_fd_);
+}
+
+void QueryServer::AcceptConnections() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            switch (errno) {
+            case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+            case EWOULDBLOCK:
+#endif
+                return;
+            // The pending connection failed or was consumed; the next one may be fine.
+            case EINTR:
+            case ECONNABORTED:
+            case EPROTO:
+            case EPERM:
+            case ENETDOWN:
+            case ENETUNREACH:
+            case EHOSTDOWN:
+            case EHOSTUNREACH:
+            case ENONET:
+            case ENOPROTOOPT:
+            case EOPNOTSUPP:
+                continue;
+            case EMFILE:
+            case ENFILE:
+                // Out of descriptors: turn the client away instead of leaving it in
+                // the backlog, where it keeps the level-triggered listen fd ready.
+                if (reserve_fd_ >= 0) {
+                    close(reserve_fd_);
+                    const int rejected_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                    const int accept_error = errno;
+                    if (rejected_fd >= 0) {
+                        close(rejected_fd);
+                    }
+                    reserve_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                    if (rejected_fd < 0 && (accept_error == EAGAIN || accept_error == EWOULDBLOCK)) {
+                        return;
+                    }
+                    if (rejected_fd >= 0 && reserve_fd_ >= 0) {
+                        continue;
+                    }
+                }
+                [[fallthrough]];
+            default:
+                // Stop polling the listen fd until a connection closes or the retry delay passes.
+                SetAcceptPaused(true);
+                return;
+            }
+        }
+        if (endpoint_.unix_path.empty()) {
+            const int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_.emplace(fd, std::move(connection));
+    }
+}
+
+void QueryServer::SetAcceptPaused(bool is_paused) {
+    if (is_paused == is_accept_paused_) {
+        return;
+    }
+    epoll_event event{};
+    event.events = is_paused ? 0 : EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, listen_fd_, &event);
+    is_accept_paused_ = is_paused;
+    accept_resume_time_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(ACCEPT_RETRY_DELAY_MS);
+}
+
+void QueryServer::ReadFrom(const std::shared_ptr<Connection>& connection) {
+    std::string& input = connection->input;
+    while (!connection->is_read_closed && !connection->IsBackedUp()) {
+        const size_t old_size = input.size();
+        input.resize(old_size + READ_CHUNK_SIZE);
+        const ssize_t read_size = read(connection->fd, input.data() + old_size, READ_CHUNK_SIZE);
+        input.resize(old_size + std::max<ssize_t>(read_size, 0));
+        if (read_size > 0) {
+            if (!QueueRequests(connection)) {
+                return;
+            }
+            continue;
+        }
+        if (read_size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_size == 0) {
+            connection->is_read_closed = true;
+            break;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            CloseConnection(connection);
+            return;
+        }
+        break;
+    }
+    UpdateEvents(connection);
+}
+
+bool QueryServer::QueueRequests(const std::shared_ptr<Connection>& connection) {
+    std::string& input = connection->input;
+    size_t offset = 0;
+    std::vector<Task> new_tasks;
+    while (input.size() - offset >= FRAME_LENGTH_SIZE) {
+        uint32_t body_size;
+        std::memcpy(&body_size, input.data() + offset, sizeof(body_size));
+        if (body_size > MAX_FRAME_SIZE || body_size < FRAME_HEADER_SIZE - FRAME_LENGTH_SIZE) {
+            CloseConnection(connection);
+            return false;
+        }
+        if (input.size() - offset - FRAME_LENGTH_SIZE < body_size) {
+            break;
+        }
+        new_tasks.push_back({ connection, input.substr(offset + FRAME_LENGTH_SIZE, body_size) });
+        offset += FRAME_LENGTH_SIZE + body_size;
+    }
+    input.erase(0, offset);
+    if (new_tasks.empty()) {
+        return true;
+    }
+    const size_t new_task_count = new_tasks.size();
+    connection->pending_request_count += new_task_count;
+    {
+        std::lock_guard guard(tasks_mutex_);
+        std::move(new_tasks.begin(), new_tasks.end(), std::back_inserter(tasks_));
+    }
+    if (new_task_count == 1) {
+        tasks_condition_.notify_one();
+    }
+    else {
+        tasks_condition_.notify_all();
+    }
+    return true;
+}
+
+void QueryServer::WriteTo(const std::shared_ptr<Connection>& connection) {
+    auto& output = connection->output;
+    while (!output.empty()) {
+        iovec iovecs[MAX_WRITE_IOVECS];
+        int iovec_count = 0;
+        size_t skip = connection->output_offset;
+        for (auto it = output.begin(); it != output.end() && iovec_count + 2 <= MAX_WRITE_IOVECS; ++it) {
+            const std::string_view parts[] = {
+                it->header,
+                { reinterpret_cast<const char*>(it->documents.data()), it->documents.size() * sizeof(Document) },
+            };
+            for (std::string_view part : parts) {
+                if (skip >= part.size()) {
+                    skip -= part.size();
+                    continue;
+                }
+                part.remove_prefix(skip);
+                skip = 0;
+                iovecs[iovec_count++] = { const_cast<char*>(part.data()), part.size() };
+            }
+        }
+        msghdr message{};
+        message.msg_iov = iovecs;
+        message.msg_iovlen = iovec_count;
+        // A client that went away must not kill the server with SIGPIPE.
+        const ssize_t written = sendmsg(connection->fd, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            CloseConnection(connection);
+            return;
+        }
+        size_t remaining = connection->output_offset + static_cast<size_t>(written);
+        while (!output.empty()) {
+            const size_t response_size = output.front().GetSize();
+            if (remaining < response_size) {
+                break;
+            }
+            remaining -= response_size;
+            connection->output_size -= response_size;
+            output.pop_front();
+        }
+        connection->output_offset = remaining;
+    }
+    UpdateEvents(connection);
+}
+
+void QueryServer::UpdateEvents(const std::shared_ptr<Connection>& connection) {
+    if (connection->IsDone()) {
+        CloseConnection(connection);
+        return;
+    }
+    uint32_t events = 0;
+    if (!connection->is_read_closed && !connection->IsBackedUp()) {
+        events |= EPOLLIN;
+    }
+    if (!connection->output.empty()) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection->events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = connection->fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+void QueryServer::CloseConnection(const std::shared_ptr<Connection>& connection) {
+    if (connection->is_closed) {
+        return;
+    }
+    connection->is_closed = true;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    connections_.erase(connection->fd);
+    connection->output.clear();
+    connection->output_size = 0;
+    SetAcceptPaused(false);
+}
+
+void QueryServer::DrainCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard guard(completions_mutex_);
+        completions.swap(completions_);
+    }
+    std::vector<std::shared_ptr<Connection>> updated_connections;
+    for (Completion& completion : completions) {
+        Connection& connection = *completion.connection;
+        --connection.pending_request_count;
+        if (connection.is_closed) {
+            continue;
+        }
+        connection.output_size += completion.response.GetSize();
+        connection.output.push_back(std::move(completion.response));
+        updated_connections.push_back(std::move(completion.connection));
+    }
+    std::sort(updated_connections.begin(), updated_connections.end());
+    updated_connections.erase(std::unique(updated_connections.begin(), updated_connections.end()), updated_connections.end());
+    // A connection gets one sendmsg for all responses that completed together.
+    for (const auto& connection : updated_connections) {
+        if (connection->is_closed) {
+            continue;
+        }
+        if (connection->events & EPOLLOUT) {
+            UpdateEvents(connection);
+        }
+        else {
+            WriteTo(connection);
+        }
+    }
+}
+
+void QueryServer::RunWorker() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock lock(tasks_mutex_);
+            tasks_condition_.wait(lock, [this] {
+                return is_shutting_down_ || !tasks_.empty();
+                });
+            if (is_shutting_down_) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        OutgoingResponse response = Execute(task.request);
+        bool needs_wake;
+        {
+            std::lock_guard guard(completions_mutex_);
+            needs_wake = completions_.empty();
+            completions_.push_back({ std::move(task.connection), std::move(response) });
+        }
+        if (needs_wake) {
+            const uint64_t wake_count = 1;
+            [[maybe_unused]] const ssize_t written = write(wake_fd_, &wake_count, sizeof(wake_count));
+        }
+    }
+}
+
+QueryServer::OutgoingResponse QueryServer::Execute(std::string_view request) {
+    using namespace std::literals;
+    FrameReader reader(request);
+    uint32_t request_id = 0;
+    uint8_t type = 0;
+    reader.Get(request_id);
+    reader.Get(type);
+    const auto bad_request = [request_id](std::string_view message) {
+        return OutgoingResponse{ MakeErrorResponse(request_id, ResponseCode::BAD_REQUEST, message), {} };
+    };
+    try {
+        switch (static_cast<RequestType>(type)) {
+        case RequestType::FIND_TOP_DOCUMENTS: {
+            DocumentStatus status;
+            std::string_view query;
+            if (!ReadStatus(reader, status) || !reader.GetString(query) || !reader.IsEnd()) {
+                return bad_request("Malformed FindTopDocuments request"sv);
+            }
+            std::vector<Document> documents;
+            {
+                std::shared_lock lock(search_server_mutex_);
+                documents = search_server_.FindTopDocuments(query, status);
+            }
+            ClearPadding(documents);
+            FrameWriter writer(request_id, static_cast<uint8_t>(ResponseCode::OK));
+            writer.Put(static_cast<uint32_t>(documents.size()));
+            return { writer.Finish(documents.size() * sizeof(Document)), std::move(documents) };
+        }
+        case RequestType::MATCH_DOCUMENT: {
+            int32_t document_id;
+            std::string_view query;
+            if (!reader.Get(document_id) || !reader.GetString(query) || !reader.IsEnd()) {
+                return bad_request("Malformed MatchDocument request"sv);
+            }
+            FrameWriter writer(request_id, static_cast<uint8_t>(ResponseCode::OK));
+            {
+                std::shared_lock lock(search_server_mutex_);
+                const auto [words, status] = search_server_.MatchDocument(query, document_id);
+                // Words point into the index, so they are copied out while the lock is held.
+                writer.Put(static_cast<uint8_t>(status));
+                writer.Put(static_cast<uint32_t>(words.size()));
+                for (std::string_view word : words) {
+                    writer.PutString(word);
+                }
+            }
+            return { writer.Finish(), {} };
+        }
+        case RequestType::ADD_DOCUMENT: {
+            int32_t document_id;
+            DocumentStatus status;
+            uint32_t rating_count;
+            if (!reader.Get(document_id) || !ReadStatus(reader, status) || !reader.Get(rating_count) || rating_count > MAX_FRAME_SIZE / sizeof(int32_t)) {
+                return bad_request("Malformed AddDocument request"sv);
+            }
+            std::vector<int> ratings(rating_count);
+            for (int& rating : ratings) {
+                int32_t value;
+                if (!reader.Get(value)) {
+                    return bad_request("Malformed AddDocument request"sv);
+                }
+                rating = value;
+            }
+            std::string_view text;
+            if (!reader.GetString(text) || !reader.IsEnd()) {
+                return bad_request("Malformed AddDocument request"sv);
+            }
+            {
+                std::unique_lock lock(search_server_mutex_);
+                search_server_.AddDocument(document_id, text, status, ratings);
+            }
+            return { FrameWriter(request_id, static_cast<uint8_t>(ResponseCode::OK)).Finish(), {} };
+        }
+        case RequestType::REMOVE_DOCUMENT: {
+            int32_t document_id;
+            if (!reader.Get(document_id) || !reader.IsEnd()) {
+                return bad_request("Malformed RemoveDocument request"sv);
+            }
+            {
+                std::unique_lock lock(search_server_mutex_);
+                search_server_.RemoveDocument(document_id);
+            }
+            return { FrameWriter(request_id, static_cast<uint8_t>(ResponseCode::OK)).Finish(), {} };
+        }
+        }
+        return bad_request("Unknown request type"sv);
+    }
+    catch (const std::invalid_argument& e) {
+        return { MakeErrorResponse(request_id, ResponseCode::INVALID_ARGUMENT, e.what()), {} };
+    }
+    catch (const std::out_of_range& e) {
+        return { MakeErrorResponse(request_id, ResponseCode::OUT_OF_RANGE, e.what()), {} };
+    }
+    catch (const std::exception& e) {
+        return { MakeErrorResponse(request_id, ResponseCode::INTERNAL_ERROR, e.what()), {} };
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../search_server.h"
+#include "endpoint.h"
+#include "protocol.h"
+
+// Serves a SearchServer over the protocol from protocol.h. One thread runs
+// the epoll loop and owns every socket; a fixed pool of workers executes
+// requests. Requests on a connection may be pipelined, and responses are
+// sent as they complete, so clients match them by request id.
+class QueryServer {
+public:
+    QueryServer(SearchServer& search_server, const Endpoint& endpoint, size_t worker_count);
+
+    QueryServer(const QueryServer&) = delete;
+
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    ~QueryServer();
+
+    // Runs the event loop on the calling thread until Stop is called.
+    void Run();
+
+    // Safe to call from any thread and from signal handlers.
+    void Stop();
+
+    uint16_t GetPort() const;
+
+private:
+    struct Connection;
+
+    struct OutgoingResponse {
+        std::string header;
+        // Sent straight from this buffer after the header.
+        std::vector<Document> documents;
+
+        size_t GetSize() const {
+            return header.size() + documents.size() * sizeof(Document);
+        }
+    };
+
+    struct Task {
+        std::shared_ptr<Connection> connection;
+        std::string request;
+    };
+
+    struct Completion {
+        std::shared_ptr<Connection> connection;
+        OutgoingResponse response;
+    };
+
+    SearchServer& search_server_;
+    std::shared_mutex search_server_mutex_;
+    Endpoint endpoint_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    // Kept open so that a connection can still be accepted and closed when
+    // the process runs out of descriptors.
+    int reserve_fd_ = -1;
+    bool is_accept_paused_ = false;
+    std::chrono::steady_clock::time_point accept_resume_time_;
+    std::atomic<bool> is_stopping_ = false;
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+
+    std::mutex tasks_mutex_;
+    std::condition_variable tasks_condition_;
+    std::deque<Task> tasks_;
+    bool is_shutting_down_ = false;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    std::vector<std::thread> workers_;
+
+    void AcceptConnections();
+
+    void SetAcceptPaused(bool is_paused);
+
+    void ReadFrom(const std::shared_ptr<Connection>& connection);
+
+    bool QueueRequests(const std::shared_ptr<Connection>& connection);
+
+    void WriteTo(const std::shared_ptr<Connection>& connection);
+
+    void UpdateEvents(const std::shared_ptr<Connection>& connection);
+
+    void CloseConnection(const std::shared_ptr<Connection>& connection);
+
+    void DrainCompletions();
+
+    void RunWorker();
+
+    OutgoingResponse Execute(std::string_view request);
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include "ranking.h"
+
+struct QueryStatistics {
+    int document_count = 0;
+    int64_t total_document_length = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+
+    void Merge(const QueryStatistics& other) {
+        document_count += other.document_count;
+        total_document_length += other.total_document_length;
+        for (const auto& [word, document_freq] : other.document_freqs) {
+            document_freqs[word] += document_freq;
+        }
+    }
+
+    int GetDocumentFreq(std::string_view word) const {
+        const auto it = document_freqs.find(word);
+        return it == document_freqs.end() ? 0 : it->second;
+    }
+
+    CorpusStatistics GetCorpusStatistics() const {
+        const double average_document_length = document_count > 0 ? static_cast<double>(total_document_length) / document_count : 0.0;
+        return { document_count, average_document_length };
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cmath>
+#include <variant>
+
+struct CorpusStatistics {
+    int document_count = 0;
+    double average_document_length = 0.0;
+};
+
+struct TfIdfRanking {
+    struct Scorer {
+        int document_count;
+
+        double ComputeTermWeight(int document_freq) const {
+            return std::log(document_count * 1.0 / document_freq);
+        }
+
+        double operator()(double term_weight, double term_freq, int term_count, int document_length) const {
+            return term_freq * term_weight;
+        }
+    };
+
+    Scorer MakeScorer(const CorpusStatistics& statistics) const {
+        return { statistics.document_count };
+    }
+};
+
+struct Bm25Ranking {
+    double k1 = 1.2;
+    double b = 0.75;
+
+    struct Scorer {
+        int document_count;
+        double k1;
+        double length_norm_base;
+        double length_norm_scale;
+
+        double ComputeTermWeight(int document_freq) const {
+            return std::log(1.0 + (document_count - document_freq + 0.5) / (document_freq + 0.5));
+        }
+
+        // The length norm depends on the average document length, which changes with every add or
+        // remove, so it is not stored per document: one multiply-add here costs less than a norm column
+        // that has to be rebuilt. Impacts are not stored for the same reason.
+        double operator()(double term_weight, double term_freq, int term_count, int document_length) const {
+            const double length_norm = length_norm_base + length_norm_scale * document_length;
+            return term_weight * term_count * (k1 + 1.0) / (term_count + length_norm);
+        }
+    };
+
+    Scorer MakeScorer(const CorpusStatistics& statistics) const {
+        const double average_length = statistics.average_document_length > 0.0 ? statistics.average_document_length : 1.0;
+        return { statistics.document_count, k1, k1 * (1.0 - b), k1 * b / average_length };
+    }
+};
+
+using RankingFunction = std::variant<TfIdfRanking, Bm25Ranking>;
@@ -2,92 +2,386 @@
 #include <cmath>
 #include <numeric>
 #include <iterator>
+#include <limits>
 #include <cassert>
 #include "search_server.h"
 
-SearchServer::SearchServer(std::string_view stop_words_text)
-    : SearchServer(SplitIntoWordsView(stop_words_text))
+SearchServer::SearchServer(std::string_view stop_words_text, const IndexOptions& options)
+    : SearchServer(SplitIntoWordsView(stop_words_text), options)
 {
 }
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-    : SearchServer(SplitIntoWordsView(std::string_view(stop_words_text)))
+SearchServer::SearchServer(const std::string& stop_words_text, const IndexOptions& options)
+    : SearchServer(SplitIntoWordsView(std::string_view(stop_words_text)), options)
 {
 }
 
+SearchServer::SearchServer(const SearchServer& other)
+    : stop_words_(other.stop_words_)
+    , options_(other.options_)
+    , word_to_term_id_(other.word_to_term_id_)
+    , term_words_(other.term_words_.size())
+    , term_postings_(other.term_postings_)
+    , free_term_ids_(other.free_term_ids_)
+    , documents_(other.documents_)
+    , ranking_(other.ranking_)
+    , forward_index_(other.forward_index_)
+    , positional_index_(other.positional_index_)
+    , trigram_index_(other.trigram_index_)
+{
+    for (const auto& [word, term_id] : word_to_term_id_) {
+        term_words_[term_id] = word;
+    }
+}
+
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    AddTokenizedDocument(document_id, SplitIntoWordsView(document), status, ratings);
+}
+
+void SearchServer::AddTokenizedDocument(int document_id, const std::vector<std::string_view>& all_words, DocumentStatus status, const std::vector<int>& ratings) {
     using namespace std::literals;
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || documents_.Contains(document_id)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    std::vector<int> positions;
+    const auto words = FilterStopWords(all_words, &positions);
 
+    const int slot = documents_.AddDocument(document_id, ComputeAverageRating(ratings), status, static_cast<int>(words.size()));
     const double inv_word_count = 1.0 / words.size();
-    auto& word_frequencies = document_id_to_word_frequencies_[document_id];
-    for (std::string_view word : words) {
-        word_to_document_freqs_[std::string(word)][document_id] += inv_word_count;
-        word_frequencies[word_to_document_freqs_.find(std::string(word))->first] += inv_word_count;
+    std::vector<std::pair<int, int>> term_positions;
+    term_positions.reserve(words.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        term_positions.push_back({ AddTerm(words[i]), positions[i] });
+    }
+    std::sort(term_positions.begin(), term_positions.end());
+
+    if (forward_index_.size() <= static_cast<size_t>(slot)) {
+        forward_index_.resize(slot + 1);
+    }
+    auto& term_weights = forward_index_[slot];
+    for (auto it = term_positions.begin(); it != term_positions.end();) {
+        const int term_id = it->first;
+        const auto it_next = std::find_if(it, term_positions.end(), [term_id](const std::pair<int, int>& term_position) {
+            return term_position.first != term_id;
+            });
+        const int term_count = static_cast<int>(it_next - it);
+        const double term_freq = term_count * inv_word_count;
+        term_postings_[term_id].emplace(document_id, Posting{ term_freq, slot, term_count });
+        term_weights.push_back({ term_id, term_freq });
+        it = it_next;
+    }
+    term_weights.shrink_to_fit();
+    if (options_.store_positions) {
+        positional_index_.AddDocument(slot, term_positions);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    document_ids_.insert(document_id);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    return FindTopDocuments(raw_query, DocumentStatusPredicate{ status });
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, size_t page_size, const SearchCursor& after) const {
+    return FindTopDocumentsPage(raw_query, DocumentStatusPredicate{ DocumentStatus::ACTUAL }, page_size, after);
+}
+
+QueryStatistics SearchServer::CollectQueryStatistics(std::string_view raw_query) const {
+    const auto query = ParseQuery(raw_query);
+    QueryStatistics statistics;
+    statistics.document_count = documents_.GetDocumentCount();
+    statistics.total_document_length = documents_.GetTotalDocumentLength();
+    for (const ResolvedTerm& term : ResolvePlusTerms(query)) {
+        statistics.document_freqs[std::string(term_words_[term.term_id])] = static_cast<int>(term_postings_[term.term_id].size());
+    }
+    return statistics;
+}
+
+SearchPage SearchServer::MergePages(const std::vector<SearchPage>& pages, size_t page_size) {
+    std::vector<Document> documents;
+    bool has_more = false;
+    for (const SearchPage& page : pages) {
+        documents.insert(documents.end(), page.documents.begin(), page.documents.end());
+        has_more = has_more || page.next_cursor.has_value();
+    }
+    SearchPage result = SelectPage(documents, page_size, SearchCursor());
+    if (has_more && !result.next_cursor && !result.documents.empty()) {
+        result.next_cursor = SearchCursor(result.documents.back());
+    }
+    return result;
+}
+
+void SearchServer::SetRankingFunction(RankingFunction ranking) {
+    ranking_ = ranking;
+}
+
+const RankingFunction& SearchServer::GetRankingFunction() const {
+    return ranking_;
+}
+
+CorpusStatistics SearchServer::GetCorpusStatistics() const {
+    return { documents_.GetDocumentCount(), documents_.GetAverageDocumentLength() };
+}
+
+std::vector<std::string_view> SearchServer::ExpandTerms(std::string_view pattern, size_t max_expansions) const {
+    using namespace std::literals;
+    if (pattern.empty() || pattern[0] == '*' || pattern[0] == '?') {
+        throw std::invalid_argument("Term pattern "s + std::string(pattern) + " must start with a letter"s);
+    }
+    std::vector<std::string_view> words;
+    for (const int term_id : ExpandPattern(pattern, max_expansions)) {
+        words.push_back(term_words_[term_id]);
+    }
+    return words;
+}
+
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return documents_.GetDocumentCount();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    auto it = document_id_to_word_frequencies_.find(document_id);
-    assert(it != document_id_to_word_frequencies_.end());
-    return it->second;
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    const auto view = GetWordFrequenciesView(document_id);
+    return { view.begin(), view.end() };
 }
 
-void SearchServer::RemoveDocument(int document_id) {
-    if (document_ids_.count(document_id)) {
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        const auto& word_frequencies = document_id_to_word_frequencies_[document_id];
-        std::vector<std::map<std::string, std::map<int, double>>::iterator> its_for_erase;
-        for (const auto& [word, freq] : word_frequencies) {
-            auto it = word_to_document_freqs_.find(word);
-            it->second.erase(document_id);
-            if (it->second.empty()) {
-                word_to_document_freqs_.erase(it);
-            }
-        }
-        document_id_to_word_frequencies_.erase(document_id);
+WordFrequenciesView SearchServer::GetWordFrequenciesView(int document_id) const {
+    static const std::vector<TermWeight> empty_term_weights;
+    const int slot = documents_.FindSlot(document_id);
+    if (slot < 0) {
+        return WordFrequenciesView(empty_term_weights, term_words_);
     }
+    return WordFrequenciesView(forward_index_[slot], term_words_);
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
-    using namespace std::string_literals;
-    if (!document_ids_.count(document_id)) {
+    const int slot = documents_.FindSlot(document_id);
+    if (slot < 0) {
         throw std::out_of_range("Id of document is not valid");
     }
     const auto query = ParseQuery(raw_query);
-    if (std::any_of(query.minus_words.begin(), query.minus_words.end(), [this, document_id](std::string_view word) {
-        auto it = word_to_document_freqs_.find(word);
-        return it != word_to_document_freqs_.end() && it->second.count(document_id);
+    auto minus_term_ids = ResolveMinusTerms(query);
+    std::vector<std::string_view> matched_words;
+    if (std::any_of(minus_term_ids.begin(), minus_term_ids.end(), [this, slot](int term_id) {
+        return HasDocumentTerm(slot, term_id);
         })) {
-        return { {}, documents_.at(document_id).status };
+        return { matched_words, documents_.GetStatus(slot) };
+    }
+    const DocumentStatus status = MatchDocument(PrepareMatchQuery(query, std::move(minus_term_ids)), document_id, matched_words);
+    return { matched_words, status };
+}
+
+SearchServer::MatchQuery SearchServer::PrepareMatchQuery(std::string_view raw_query) const {
+    const auto query = ParseQuery(raw_query);
+    return PrepareMatchQuery(query, ResolveMinusTerms(query));
+}
+
+SearchServer::MatchQuery SearchServer::PrepareMatchQuery(const Query& query, std::vector<int> minus_term_ids) const {
+    MatchQuery match_query;
+    match_query.minus_term_ids_ = std::move(minus_term_ids);
+    for (const ResolvedTerm& term : ResolvePlusTerms(query)) {
+        match_query.plus_term_ids_.push_back(term.term_id);
+    }
+    if (!query.plus_patterns.empty() || !query.plus_fuzzy_words.empty()) {
+        std::sort(match_query.plus_term_ids_.begin(), match_query.plus_term_ids_.end(), [this](int lhs, int rhs) {
+            return term_words_[lhs] < term_words_[rhs];
+            });
+    }
+    if (!query.phrases.empty()) {
+        auto phrases = PreparePhrases(query);
+        if (phrases) {
+            match_query.phrases_ = std::move(*phrases);
+        }
+        else {
+            match_query.can_match_ = false;
+        }
+    }
+    return match_query;
+}
+
+DocumentStatus SearchServer::MatchDocument(const MatchQuery& query, int document_id, std::vector<std::string_view>& matched_words) const {
+    const int slot = documents_.FindSlot(document_id);
+    if (slot < 0) {
+        throw std::out_of_range("Id of document is not valid");
+    }
+    matched_words.clear();
+    if (!query.can_match_ || std::any_of(query.minus_term_ids_.begin(), query.minus_term_ids_.end(), [this, slot](int term_id) {
+        return HasDocumentTerm(slot, term_id);
+        })) {
+        return documents_.GetStatus(slot);
+    }
+    if (!query.phrases_.empty() && !MatchesPhrases(slot, query.phrases_, query.first_positions_, query.positions_)) {
+        return documents_.GetStatus(slot);
+    }
+    for (const int term_id : query.plus_term_ids_) {
+        if (HasDocumentTerm(slot, term_id)) {
+            matched_words.push_back(term_words_[term_id]);
+        }
+    }
+    return documents_.GetStatus(slot);
+}
+
+bool SearchServer::HasDocumentTerm(int slot, int term_id) const {
+    const auto& term_weights = forward_index_[slot];
+    const auto it = std::lower_bound(term_weights.begin(), term_weights.end(), term_id, [](const TermWeight& term_weight, int term_id) {
+        return term_weight.term_id < term_id;
+        });
+    return it != term_weights.end() && it->term_id == term_id;
+}
+
+int SearchServer::FindTermId(std::string_view word) const {
+    const auto it = word_to_term_id_.find(word);
+    return it == word_to_term_id_.end() ? -1 : it->second;
+}
+
+int SearchServer::AddTerm(std::string_view word) {
+    const auto it = word_to_term_id_.find(word);
+    if (it != word_to_term_id_.end()) {
+        return it->second;
+    }
+    int term_id;
+    if (!free_term_ids_.empty()) {
+        term_id = free_term_ids_.back();
+        free_term_ids_.pop_back();
+    }
+    else {
+        term_id = static_cast<int>(term_words_.size());
+        term_words_.emplace_back();
+        term_postings_.emplace_back();
+    }
+    term_words_[term_id] = word_to_term_id_.emplace(std::string(word), term_id).first->first;
+    if (options_.index_fuzzy_terms) {
+        trigram_index_.AddTerm(term_id, term_words_[term_id]);
+    }
+    return term_id;
+}
+
+void SearchServer::RemoveTermIfUnused(int term_id) {
+    if (!term_postings_[term_id].empty() || term_words_[term_id].empty()) {
+        return;
+    }
+    if (options_.index_fuzzy_terms) {
+        trigram_index_.RemoveTerm(term_id, term_words_[term_id]);
+    }
+    word_to_term_id_.erase(word_to_term_id_.find(term_words_[term_id]));
+    term_words_[term_id] = {};
+    free_term_ids_.push_back(term_id);
+}
+
+bool SearchServer::MatchesPattern(std::string_view word, std::string_view pattern) {
+    size_t word_pos = 0;
+    size_t pattern_pos = 0;
+    size_t star_pos = std::string_view::npos;
+    size_t star_word_pos = 0;
+    while (word_pos < word.size()) {
+        if (pattern_pos < pattern.size() && (pattern[pattern_pos] == '?' || pattern[pattern_pos] == word[word_pos])) {
+            ++word_pos;
+            ++pattern_pos;
+        }
+        else if (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+            star_pos = pattern_pos++;
+            star_word_pos = word_pos;
+        }
+        else if (star_pos != std::string_view::npos) {
+            pattern_pos = star_pos + 1;
+            word_pos = ++star_word_pos;
+        }
+        else {
+            return false;
+        }
+    }
+    while (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+        ++pattern_pos;
     }
-    std::vector<std::string_view> matched_words(query.plus_words.size());
-    auto it_for_erase = std::copy_if(query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [this, document_id](std::string_view word) {
-        auto it = word_to_document_freqs_.find(word);
-        return it != word_to_document_freqs_.end() && it->second.count(document_id);
+    return pattern_pos == pattern.size();
+}
+
+std::vector<int> SearchServer::ExpandPattern(std::string_view pattern, size_t max_expansions) const {
+    const std::string_view prefix = pattern.substr(0, pattern.find_first_of("*?"));
+    const bool is_prefix_pattern = prefix.size() + 1 == pattern.size() && pattern.back() == '*';
+    std::vector<int> term_ids;
+    for (auto it = word_to_term_id_.lower_bound(prefix); it != word_to_term_id_.end() && term_ids.size() < max_expansions; ++it) {
+        const std::string_view word = it->first;
+        if (word.substr(0, prefix.size()) != prefix) {
+            break;
+        }
+        if (is_prefix_pattern || MatchesPattern(word, pattern)) {
+            term_ids.push_back(it->second);
+        }
+    }
+    return term_ids;
+}
+
+std::vector<int> SearchServer::ExpandPatterns(const std::vector<std::string_view>& patterns, size_t max_expansions) const {
+    std::vector<int> term_ids;
+    for (std::string_view pattern : patterns) {
+        const auto pattern_term_ids = ExpandPattern(pattern, max_expansions);
+        term_ids.insert(term_ids.end(), pattern_term_ids.begin(), pattern_term_ids.end());
+    }
+    return term_ids;
+}
+
+std::vector<std::pair<int, int>> SearchServer::ExpandFuzzyWord(const FuzzyWord& word, size_t max_expansions) const {
+    using namespace std::literals;
+    if (!options_.index_fuzzy_terms) {
+        throw std::invalid_argument("Fuzzy query words need a fuzzy term index"s);
+    }
+    return trigram_index_.FindTerms(word.data, word.max_distance, term_words_, max_expansions);
+}
+
+std::vector<SearchServer::ResolvedTerm> SearchServer::ResolvePlusTerms(const Query& query) const {
+    std::vector<ResolvedTerm> terms;
+    terms.reserve(query.plus_words.size());
+    for (std::string_view word : query.plus_words) {
+        const int term_id = FindTermId(word);
+        if (term_id >= 0) {
+            terms.push_back({ term_id, 1.0 });
+        }
+    }
+    if (query.plus_patterns.empty() && query.plus_fuzzy_words.empty()) {
+        return terms;
+    }
+    for (const int term_id : ExpandPatterns(query.plus_patterns, MAX_TERM_EXPANSIONS)) {
+        terms.push_back({ term_id, 1.0 });
+    }
+    for (const FuzzyWord& word : query.plus_fuzzy_words) {
+        for (const auto& [term_id, distance] : ExpandFuzzyWord(word, MAX_TERM_EXPANSIONS)) {
+            terms.push_back({ term_id, std::pow(FUZZY_DISTANCE_PENALTY, distance) });
+        }
+    }
+    std::sort(terms.begin(), terms.end(), [](const ResolvedTerm& lhs, const ResolvedTerm& rhs) {
+        return lhs.term_id < rhs.term_id || (lhs.term_id == rhs.term_id && lhs.weight_factor > rhs.weight_factor);
         });
-    matched_words.resize(it_for_erase - matched_words.begin());
-    return { matched_words, documents_.at(document_id).status };
+    terms.erase(std::unique(terms.begin(), terms.end(), [](const ResolvedTerm& lhs, const ResolvedTerm& rhs) {
+        return lhs.term_id == rhs.term_id;
+        }), terms.end());
+    return terms;
+}
+
+std::vector<int> SearchServer::ResolveMinusTerms(const Query& query) const {
+    // Only plus expansions are capped: a minus pattern or fuzzy word has to exclude every word it matches.
+    std::vector<int> term_ids = ExpandPatterns(query.minus_patterns, std::numeric_limits<size_t>::max());
+    for (std::string_view word : query.minus_words) {
+        const int term_id = FindTermId(word);
+        if (term_id >= 0) {
+            term_ids.push_back(term_id);
+        }
+    }
+    for (const FuzzyWord& word : query.minus_fuzzy_words) {
+        for (const auto& [term_id, _] : ExpandFuzzyWord(word, std::numeric_limits<size_t>::max())) {
+            term_ids.push_back(term_id);
+        }
+    }
+    return term_ids;
 }
 
 bool SearchServer::IsStopWord(std::string_view word) const {
@@ -100,16 +394,21 @@ bool SearchServer::IsValidWord(std::string_view word) {
         });
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+std::vector<std::string_view> SearchServer::FilterStopWords(const std::vector<std::string_view>& all_words, std::vector<int>* positions) const {
     using namespace std::literals;
     std::vector<std::string_view> words;
-    for (std::string_view word : SplitIntoWordsView(text)) {
+    int position = 0;
+    for (std::string_view word : all_words) {
         if (!IsValidWord(word)) {
             throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
         }
-        if (!IsStopWord(std::string(word))) {
+        if (!IsStopWord(word)) {
             words.push_back(word);
+            if (positions) {
+                positions->push_back(position);
+            }
         }
+        ++position;
     }
     return words;
 }
@@ -131,18 +430,90 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         text.remove_prefix(1);
     }
-    if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
+    int fuzzy_distance = 0;
+    const size_t tilde_pos = text.rfind('~');
+    if (tilde_pos != std::string_view::npos && tilde_pos > 0) {
+        const std::string_view distance_text = text.substr(tilde_pos + 1);
+        if (distance_text.empty()) {
+            fuzzy_distance = 1;
+        }
+        else if (distance_text.size() == 1 && distance_text[0] >= '1' && distance_text[0] <= '0' + MAX_FUZZY_DISTANCE) {
+            fuzzy_distance = distance_text[0] - '0';
+        }
+        if (fuzzy_distance > 0) {
+            text = text.substr(0, tilde_pos);
+        }
+    }
+    if (text.empty() || text[0] == '-' || text[0] == '*' || text[0] == '?' || !IsValidWord(text)) {
         throw std::invalid_argument("Query word "s + std::string(text) + " is invalid");
     }
+    const bool is_pattern = text.find_first_of("*?") != std::string_view::npos;
+    if (is_pattern && fuzzy_distance > 0) {
+        throw std::invalid_argument("Query word "s + std::string(text) + " cannot be both a pattern and fuzzy"s);
+    }
 
-    return { text, is_minus, IsStopWord(text) };
+    return { text, is_minus, !is_pattern && fuzzy_distance == 0 && IsStopWord(text), is_pattern, fuzzy_distance };
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool is_sort_and_unique) const {
+    using namespace std::literals;
     Query result;
+    bool is_in_phrase = false;
+    Phrase phrase;
+    int phrase_offset = 0;
     for (std::string_view word : SplitIntoWordsView(text)) {
+        if (!is_in_phrase && word[0] == '"') {
+            word.remove_prefix(1);
+            is_in_phrase = true;
+            phrase = {};
+            phrase_offset = 0;
+        }
+        if (is_in_phrase) {
+            const bool is_phrase_end = !word.empty() && word.back() == '"';
+            if (is_phrase_end) {
+                word.remove_suffix(1);
+            }
+            if (!word.empty()) {
+                const auto query_word = ParseQueryWord(word);
+                if (query_word.is_minus || query_word.is_pattern || query_word.fuzzy_distance > 0) {
+                    throw std::invalid_argument("Word "s + std::string(word) + " is not allowed inside a phrase"s);
+                }
+                if (!query_word.is_stop) {
+                    if (phrase.words.empty()) {
+                        phrase_offset = 0;
+                    }
+                    phrase.words.push_back(query_word.data);
+                    phrase.offsets.push_back(phrase_offset);
+                    result.plus_words.push_back(query_word.data);
+                }
+                ++phrase_offset;
+            }
+            if (is_phrase_end) {
+                is_in_phrase = false;
+                if (phrase.words.size() > 1) {
+                    result.phrases.push_back(std::move(phrase));
+                }
+            }
+            continue;
+        }
         const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
+        if (query_word.fuzzy_distance > 0) {
+            if (query_word.is_minus) {
+                result.minus_fuzzy_words.push_back({ query_word.data, query_word.fuzzy_distance });
+            }
+            else {
+                result.plus_fuzzy_words.push_back({ query_word.data, query_word.fuzzy_distance });
+            }
+        }
+        else if (query_word.is_pattern) {
+            if (query_word.is_minus) {
+                result.minus_patterns.push_back(query_word.data);
+            }
+            else {
+                result.plus_patterns.push_back(query_word.data);
+            }
+        }
+        else if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 result.minus_words.push_back(query_word.data);
             }
@@ -151,6 +522,9 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool is_sort
             }
         }
     }
+    if (is_in_phrase) {
+        throw std::invalid_argument("Phrase is not closed"s);
+    }
     if (is_sort_and_unique) {
         std::sort(result.plus_words.begin(), result.plus_words.end());
         auto it_end_for_plus_words = std::unique(result.plus_words.begin(), result.plus_words.end());
@@ -162,6 +536,117 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool is_sort
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.find(word)->second.size());
-}
\ No newline at end of file
+bool SearchServer::IsRankedBefore(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) >= EPSILON) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+SearchPage SearchServer::SelectPage(const std::vector<Document>& documents, size_t page_size, const SearchCursor& after) {
+    // Bounded heap keyed by IsRankedBefore: its front is the worst document kept so far.
+    std::vector<Document> page;
+    page.reserve(std::min(page_size, documents.size()));
+    size_t documents_after_cursor = 0;
+    for (const Document& document : documents) {
+        if (after.last_document_ && !IsRankedBefore(*after.last_document_, document)) {
+            continue;
+        }
+        ++documents_after_cursor;
+        if (page.size() < page_size) {
+            page.push_back(document);
+            std::push_heap(page.begin(), page.end(), IsRankedBefore);
+        }
+        else if (page_size > 0 && IsRankedBefore(document, page.front())) {
+            std::pop_heap(page.begin(), page.end(), IsRankedBefore);
+            page.back() = document;
+            std::push_heap(page.begin(), page.end(), IsRankedBefore);
+        }
+    }
+    std::sort_heap(page.begin(), page.end(), IsRankedBefore);
+
+    SearchPage result;
+    if (documents_after_cursor > page.size() && !page.empty()) {
+        result.next_cursor = SearchCursor(page.back());
+    }
+    result.documents = std::move(page);
+    return result;
+}
+
+std::optional<std::vector<SearchServer::PreparedPhrase>> SearchServer::PreparePhrases(const Query& query) const {
+    using namespace std::literals;
+    if (!options_.store_positions) {
+        throw std::invalid_argument("Phrase queries need a positional index"s);
+    }
+    std::vector<PreparedPhrase> phrases;
+    phrases.reserve(query.phrases.size());
+    for (const Phrase& phrase : query.phrases) {
+        PreparedPhrase prepared_phrase;
+        prepared_phrase.reserve(phrase.words.size());
+        for (size_t i = 0; i < phrase.words.size(); ++i) {
+            const int term_id = FindTermId(phrase.words[i]);
+            if (term_id < 0) {
+                return std::nullopt;
+            }
+            prepared_phrase.push_back({ term_id, phrase.offsets[i] });
+        }
+        phrases.push_back(std::move(prepared_phrase));
+    }
+    return phrases;
+}
+
+std::vector<std::pair<int, int>> SearchServer::IntersectPhraseTerms(const std::vector<PreparedPhrase>& phrases, const std::vector<bool>& excluded_slots) const {
+    std::vector<int> term_ids;
+    for (const PreparedPhrase& phrase : phrases) {
+        for (const PhraseTerm& term : phrase) {
+            term_ids.push_back(term.term_id);
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    std::sort(term_ids.begin(), term_ids.end(), [this](int lhs, int rhs) {
+        return term_postings_[lhs].size() < term_postings_[rhs].size();
+        });
+
+    // Walks the rarest list and probes each document's forward index for the other words.
+    std::vector<std::pair<int, int>> candidates;
+    for (const auto& [document_id, posting] : term_postings_[term_ids.front()]) {
+        if (!excluded_slots.empty() && excluded_slots[posting.slot]) {
+            continue;
+        }
+        const int slot = posting.slot;
+        if (std::all_of(term_ids.begin() + 1, term_ids.end(), [this, slot](int term_id) {
+            return HasDocumentTerm(slot, term_id);
+            })) {
+            candidates.push_back({ document_id, slot });
+        }
+    }
+    return candidates;
+}
+
+bool SearchServer::MatchesPhrases(int slot, const std::vector<PreparedPhrase>& phrases, std::vector<int>& first_positions, std::vector<int>& positions) const {
+    for (const PreparedPhrase& phrase : phrases) {
+        if (!std::all_of(phrase.begin(), phrase.end(), [this, slot](const PhraseTerm& term) {
+            return positional_index_.HasTerm(slot, term.term_id);
+            })) {
+            return false;
+        }
+    }
+    for (const PreparedPhrase& phrase : phrases) {
+        positional_index_.DecodePositions(slot, phrase[0].term_id, first_positions);
+        for (size_t i = 1; i < phrase.size() && !first_positions.empty(); ++i) {
+            positional_index_.DecodePositions(slot, phrase[i].term_id, positions);
+            const int shift = phrase[i].offset - phrase[0].offset;
+            first_positions.erase(std::remove_if(first_positions.begin(), first_positions.end(), [&positions, shift](int position) {
+                return !std::binary_search(positions.begin(), positions.end(), position + shift);
+                }), first_positions.end());
+        }
+        if (first_positions.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -7,6 +7,7 @@
 #include <map>
 #include <unordered_map>
 #include <tuple>
+#include <optional>
 #include <algorithm>
 #include <execution>
 #include <functional>
@@ -15,23 +16,86 @@
 
 #include "string_processing.h"
 #include "document.h"
+#include "document_predicates.h"
+#include "adaptive_execution.h"
+#include "document_store.h"
+#include "ranking.h"
+#include "query_statistics.h"
+#include "word_frequencies_view.h"
+#include "index_options.h"
+#include "positional_index.h"
+#include "trigram_index.h"
 #include "log_duration.h"
 #include "concurrent_map.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
+const size_t MAX_TERM_EXPANSIONS = 64;
+const int MAX_FUZZY_DISTANCE = 2;
+const double FUZZY_DISTANCE_PENALTY = 0.5;
+const size_t PARALLEL_QUERY_MIN_POSTINGS = 20000;
+// A minus term gets an exclusion bitmap over all slots only when its postings number at least
+// this share of the plus postings; the documents of rarer ones are dropped after scoring.
+const double MINUS_BITMAP_MIN_POSTING_SHARE = 0.125;
+
+class SearchCursor {
+public:
+    SearchCursor() = default;
+
+    // Rebuilds the cursor that follows a document, e.g. after it was sent between processes.
+    SearchCursor(double relevance, int rating, int document_id)
+        : last_document_(Document(document_id, relevance, rating)) {
+    }
+
+    // The start cursor has no last document, and the getters below must not be called on it.
+    bool IsStart() const {
+        return !last_document_.has_value();
+    }
+
+    double GetRelevance() const {
+        return last_document_->relevance;
+    }
+
+    int GetRating() const {
+        return last_document_->rating;
+    }
+
+    int GetDocumentId() const {
+        return last_document_->id;
+    }
+
+private:
+    friend class SearchServer;
+
+    SearchCursor(const Document& last_document)
+        : last_document_(last_document) {
+    }
+
+    std::optional<Document> last_document_;
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    std::optional<SearchCursor> next_cursor;
+};
 
 class SearchServer {
 public:
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
+    explicit SearchServer(const StringContainer& stop_words, const IndexOptions& options = IndexOptions());
+
+    explicit SearchServer(std::string_view stop_words_text, const IndexOptions& options = IndexOptions());
 
-    explicit SearchServer(std::string_view stop_words_text);
+    explicit SearchServer(const std::string& stop_words_text, const IndexOptions& options = IndexOptions());
 
-    explicit SearchServer(const std::string& stop_words_text);
+    SearchServer(const SearchServer& other);
+
+    SearchServer(SearchServer&& other) = default;
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    void AddTokenizedDocument(int document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings);
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
 
@@ -48,14 +112,43 @@ public:
     template<typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&&, std::string_view raw_query) const;
 
+    template <typename DocumentPredicate, typename Ranking>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking) const;
+
+    template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&&, std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking) const;
+
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, size_t page_size, const SearchCursor& after = SearchCursor()) const;
+
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentPredicate document_predicate, size_t page_size, const SearchCursor& after = SearchCursor()) const;
+
+    template<typename ExecutionPolicy, typename DocumentPredicate>
+    SearchPage FindTopDocumentsPage(ExecutionPolicy&&, std::string_view raw_query, DocumentPredicate document_predicate, size_t page_size, const SearchCursor& after = SearchCursor()) const;
+
+    template<typename ExecutionPolicy, typename DocumentPredicate>
+    SearchPage FindTopDocumentsPage(ExecutionPolicy&&, std::string_view raw_query, DocumentPredicate document_predicate, const QueryStatistics& statistics, size_t page_size, const SearchCursor& after = SearchCursor()) const;
+
+    QueryStatistics CollectQueryStatistics(std::string_view raw_query) const;
+
+    static SearchPage MergePages(const std::vector<SearchPage>& pages, size_t page_size);
+
+    void SetRankingFunction(RankingFunction ranking);
+
+    const RankingFunction& GetRankingFunction() const;
+
+    CorpusStatistics GetCorpusStatistics() const;
+
+    std::vector<std::string_view> ExpandTerms(std::string_view pattern, size_t max_expansions = MAX_TERM_EXPANSIONS) const;
+
     int GetDocumentCount() const;
 
     auto begin() const {
-        return document_ids_.begin();
+        return documents_.begin();
     }
 
     auto end() const {
-        return document_ids_.end();
+        return documents_.end();
     }
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
@@ -63,29 +156,70 @@ public:
     template<typename ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    class MatchQuery;
+
+    // The prepared query stays valid until the server is modified. It also holds
+    // scratch buffers for phrase matching, so each thread needs its own.
+    MatchQuery PrepareMatchQuery(std::string_view raw_query) const;
+
+    DocumentStatus MatchDocument(const MatchQuery& query, int document_id, std::vector<std::string_view>& matched_words) const;
+
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+
+    WordFrequenciesView GetWordFrequenciesView(int document_id) const;
 
     void RemoveDocument(int document_id);
 
     template<typename ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
 
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    template<typename ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
 private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
+    struct Posting {
+        double term_freq;
+        int slot;
+        int term_count;
     };
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string, std::map<int, double>, std::less<>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
-    std::unordered_map<int, std::map<std::string_view, double>> document_id_to_word_frequencies_;
+    const IndexOptions options_;
+    std::map<std::string, int, std::less<>> word_to_term_id_;
+    std::vector<std::string_view> term_words_;
+    std::vector<std::map<int, Posting>> term_postings_;
+    std::vector<int> free_term_ids_;
+    DocumentStore documents_;
+    RankingFunction ranking_;
+    std::vector<std::vector<TermWeight>> forward_index_;
+    PositionalIndex positional_index_;
+    TrigramIndex trigram_index_;
+
+    int FindTermId(std::string_view word) const;
+
+    int AddTerm(std::string_view word);
+
+    void RemoveTermIfUnused(int term_id);
+
+    static bool MatchesPattern(std::string_view word, std::string_view pattern);
+
+    std::vector<int> ExpandPattern(std::string_view pattern, size_t max_expansions) const;
+
+    std::vector<int> ExpandPatterns(const std::vector<std::string_view>& patterns, size_t max_expansions) const;
+
+    struct FuzzyWord {
+        std::string_view data;
+        int max_distance;
+    };
+
+    std::vector<std::pair<int, int>> ExpandFuzzyWord(const FuzzyWord& word, size_t max_expansions) const;
 
     bool IsStopWord(std::string_view word) const;
 
     static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    std::vector<std::string_view> FilterStopWords(const std::vector<std::string_view>& words, std::vector<int>* positions = nullptr) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
@@ -93,29 +227,120 @@ private:
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        bool is_pattern;
+        int fuzzy_distance;
     };
 
     QueryWord ParseQueryWord(std::string_view text) const;
 
+    struct Phrase {
+        std::vector<std::string_view> words;
+        std::vector<int> offsets;
+    };
+
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<std::string_view> plus_patterns;
+        std::vector<std::string_view> minus_patterns;
+        std::vector<FuzzyWord> plus_fuzzy_words;
+        std::vector<FuzzyWord> minus_fuzzy_words;
+        std::vector<Phrase> phrases;
     };
 
     Query ParseQuery(std::string_view text, bool is_sort_and_unique = true) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    struct ResolvedTerm {
+        int term_id;
+        double weight_factor;
+    };
+
+    std::vector<ResolvedTerm> ResolvePlusTerms(const Query& query) const;
+
+    std::vector<int> ResolveMinusTerms(const Query& query) const;
+
+    struct PhraseTerm {
+        int term_id;
+        int offset;
+    };
+
+    using PreparedPhrase = std::vector<PhraseTerm>;
+
+    std::optional<std::vector<PreparedPhrase>> PreparePhrases(const Query& query) const;
+
+    // first_positions and positions are scratch buffers, reused to avoid allocating per document.
+    bool MatchesPhrases(int slot, const std::vector<PreparedPhrase>& phrases, std::vector<int>& first_positions, std::vector<int>& positions) const;
+
+    std::vector<std::pair<int, int>> IntersectPhraseTerms(const std::vector<PreparedPhrase>& phrases, const std::vector<bool>& excluded_slots) const;
+
+    bool HasDocumentTerm(int slot, int term_id) const;
+
+    MatchQuery PrepareMatchQuery(const Query& query, std::vector<int> minus_term_ids) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    bool IsPostingAccepted(const DocumentPredicate& document_predicate, int document_id, const Posting& posting) const;
 
-    template<typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy&&, const Query& query, DocumentPredicate document_predicate) const;
+    struct ScoredTerm {
+        const std::map<int, Posting>* postings;
+        double weight;
+    };
+
+    template <typename Scorer>
+    std::vector<ScoredTerm> PrepareScoredTerms(const Query& query, const Scorer& scorer, const QueryStatistics* statistics) const;
+
+    struct QueryPlan {
+        std::vector<ScoredTerm> plus_terms;
+        std::vector<bool> excluded_slots;
+        std::vector<const std::map<int, Posting>*> rare_minus_postings;
+        bool has_phrases = false;
+        std::vector<PreparedPhrase> phrases;
+        // (document id, slot) of documents with every phrase word; positions are not checked yet.
+        std::vector<std::pair<int, int>> phrase_candidates;
+        size_t posting_count = 0;
+        bool is_parallel = false;
+    };
+
+    template <typename Scorer>
+    QueryPlan PlanQuery(const Query& query, const Scorer& scorer, const QueryStatistics* statistics) const;
+
+    template <typename DocumentPredicate, typename Scorer, typename RelevanceAccumulator>
+    void ScoreTerm(const ScoredTerm& term, const std::vector<bool>& excluded_slots, const DocumentPredicate& document_predicate, const Scorer& scorer,
+        RelevanceAccumulator&& accumulate) const;
+
+    static bool IsRankedBefore(const Document& lhs, const Document& rhs);
+
+    static SearchPage SelectPage(const std::vector<Document>& documents, size_t page_size, const SearchCursor& after);
+
+    template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+    SearchPage FindDocumentsPage(ExecutionPolicy&&, std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking,
+        const QueryStatistics* statistics, size_t page_size, const SearchCursor& after) const;
+
+    template <typename DocumentPredicate, typename Ranking>
+    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate, const Ranking& ranking, const QueryStatistics* statistics) const;
+
+    template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&&, const Query& query, DocumentPredicate document_predicate, const Ranking& ranking, const QueryStatistics* statistics) const;
+
+    template<typename ExecutionPolicy, typename DocumentPredicate, typename Scorer>
+    std::vector<Document> ExecuteQueryPlan(ExecutionPolicy&&, const QueryPlan& plan, const DocumentPredicate& document_predicate, const Scorer& scorer) const;
+};
+
+class SearchServer::MatchQuery {
+private:
+    friend class SearchServer;
+
+    std::vector<int> plus_term_ids_;
+    std::vector<int> minus_term_ids_;
+    std::vector<PreparedPhrase> phrases_;
+    bool can_match_ = true;
+    mutable std::vector<int> first_positions_;
+    mutable std::vector<int> positions_;
 };
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
+SearchServer::SearchServer(const StringContainer& stop_words, const IndexOptions& options)
     : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , options_(options)
 {
     using namespace std::literals;
     if (!std::all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
@@ -130,29 +355,51 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
 
 template<typename ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+    return FindTopDocuments(policy, raw_query, document_predicate, ranking_);
+}
 
-    std::sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-            return lhs.rating > rhs.rating;
-        }
-        else {
-            return lhs.relevance > rhs.relevance;
-        }
-        });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
+template <typename DocumentPredicate, typename Ranking>
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, ranking);
+}
 
-    return matched_documents;
+template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking) const {
+    return FindDocumentsPage(policy, raw_query, document_predicate, ranking, nullptr, MAX_RESULT_DOCUMENT_COUNT, SearchCursor()).documents;
+}
+
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, DocumentPredicate document_predicate, size_t page_size, const SearchCursor& after) const {
+    return FindTopDocumentsPage(std::execution::seq, raw_query, document_predicate, page_size, after);
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate>
+SearchPage SearchServer::FindTopDocumentsPage(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t page_size, const SearchCursor& after) const {
+    return FindDocumentsPage(policy, raw_query, document_predicate, ranking_, nullptr, page_size, after);
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate>
+SearchPage SearchServer::FindTopDocumentsPage(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const QueryStatistics& statistics, size_t page_size, const SearchCursor& after) const {
+    return FindDocumentsPage(policy, raw_query, document_predicate, ranking_, &statistics, page_size, after);
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+SearchPage SearchServer::FindDocumentsPage(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, const Ranking& ranking,
+    const QueryStatistics* statistics, size_t page_size, const SearchCursor& after) const {
+    if constexpr (std::is_same_v<Ranking, RankingFunction>) {
+        return std::visit([this, &policy, raw_query, &document_predicate, statistics, page_size, &after](const auto& concrete_ranking) {
+            return FindDocumentsPage(policy, raw_query, document_predicate, concrete_ranking, statistics, page_size, after);
+            }, ranking);
+    }
+    else {
+        const auto query = ParseQuery(raw_query);
+        return SelectPage(FindAllDocuments(policy, query, document_predicate, ranking, statistics), page_size, after);
+    }
 }
 
 template<typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    return FindTopDocuments(policy, raw_query, DocumentStatusPredicate{ status });
 }
 
 template<typename ExecutionPolicy>
@@ -160,85 +407,275 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, s
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
+template <typename DocumentPredicate, typename Ranking>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate, const Ranking& ranking, const QueryStatistics* statistics) const {
+    return FindAllDocuments(std::execution::seq, query, document_predicate, ranking, statistics);
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+bool SearchServer::IsPostingAccepted(const DocumentPredicate& document_predicate, int document_id, const Posting& posting) const {
+    if constexpr (std::is_same_v<DocumentPredicate, AnyDocumentPredicate>) {
+        return true;
+    }
+    else if constexpr (std::is_same_v<DocumentPredicate, DocumentStatusPredicate>) {
+        return documents_.HasStatus(posting.slot, document_predicate.status);
+    }
+    else if constexpr (std::is_same_v<DocumentPredicate, DocumentRatingPredicate>) {
+        const int rating = documents_.GetRating(posting.slot);
+        return document_predicate.min_rating <= rating && rating <= document_predicate.max_rating;
+    }
+    else {
+        return document_predicate(document_id, documents_.GetStatus(posting.slot), documents_.GetRating(posting.slot));
+    }
 }
 
-template<typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(std::thread::hardware_concurrency());
-    auto processing_for_plus_words = [this, document_predicate, &document_to_relevance](std::string_view word) {
-        if (word_to_document_freqs_.count(word)) {
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.find(word)->second) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+template <typename Scorer>
+std::vector<SearchServer::ScoredTerm> SearchServer::PrepareScoredTerms(const Query& query, const Scorer& scorer, const QueryStatistics* statistics) const {
+    const auto resolved_terms = ResolvePlusTerms(query);
+    std::vector<ScoredTerm> terms;
+    terms.reserve(resolved_terms.size());
+    for (const auto [term_id, weight_factor] : resolved_terms) {
+        const auto& postings = term_postings_[term_id];
+        int document_freq = static_cast<int>(postings.size());
+        if (statistics) {
+            document_freq = std::max(document_freq, statistics->GetDocumentFreq(term_words_[term_id]));
+        }
+        terms.push_back({ &postings, scorer.ComputeTermWeight(document_freq) * weight_factor });
+    }
+    return terms;
+}
+
+template <typename Scorer>
+SearchServer::QueryPlan SearchServer::PlanQuery(const Query& query, const Scorer& scorer, const QueryStatistics* statistics) const {
+    QueryPlan plan;
+    std::vector<const std::map<int, Posting>*> minus_postings;
+    for (const int term_id : ResolveMinusTerms(query)) {
+        const auto& postings = term_postings_[term_id];
+        if (static_cast<int>(postings.size()) == documents_.GetDocumentCount()) {
+            return plan;
+        }
+        if (!postings.empty()) {
+            minus_postings.push_back(&postings);
+        }
+    }
+    plan.plus_terms = PrepareScoredTerms(query, scorer, statistics);
+    plan.plus_terms.erase(std::remove_if(plan.plus_terms.begin(), plan.plus_terms.end(), [&minus_postings](const ScoredTerm& term) {
+        return term.postings->empty() || std::find(minus_postings.begin(), minus_postings.end(), term.postings) != minus_postings.end();
+        }), plan.plus_terms.end());
+    if (plan.plus_terms.empty()) {
+        return plan;
+    }
+    std::sort(plan.plus_terms.begin(), plan.plus_terms.end(), [](const ScoredTerm& lhs, const ScoredTerm& rhs) {
+        return lhs.postings->size() > rhs.postings->size();
+        });
+    size_t plus_posting_count = 0;
+    for (const ScoredTerm& term : plan.plus_terms) {
+        plus_posting_count += term.postings->size();
+    }
+    for (const auto* postings : minus_postings) {
+        if (postings->size() < plus_posting_count * MINUS_BITMAP_MIN_POSTING_SHARE) {
+            plan.rare_minus_postings.push_back(postings);
+            continue;
+        }
+        plan.excluded_slots.resize(documents_.GetSlotCount());
+        for (const auto& [_, posting] : *postings) {
+            plan.excluded_slots[posting.slot] = true;
+        }
+    }
+    if (!query.phrases.empty()) {
+        auto phrases = PreparePhrases(query);
+        if (!phrases) {
+            plan.plus_terms.clear();
+            return plan;
+        }
+        plan.has_phrases = true;
+        plan.phrases = std::move(*phrases);
+        plan.phrase_candidates = IntersectPhraseTerms(plan.phrases, plan.excluded_slots);
+        plan.phrase_candidates.erase(std::remove_if(plan.phrase_candidates.begin(), plan.phrase_candidates.end(), [&plan](const std::pair<int, int>& candidate) {
+            return std::any_of(plan.rare_minus_postings.begin(), plan.rare_minus_postings.end(), [&candidate](const std::map<int, Posting>* postings) {
+                return postings->count(candidate.first) > 0;
+                });
+            }), plan.phrase_candidates.end());
+        plan.posting_count = plan.phrase_candidates.size() * plan.plus_terms.size();
+    }
+    else {
+        plan.posting_count = plus_posting_count;
+    }
+    plan.is_parallel = plan.plus_terms.size() > 1 && plan.posting_count >= PARALLEL_QUERY_MIN_POSTINGS && std::thread::hardware_concurrency() > 1;
+    return plan;
+}
+
+template <typename DocumentPredicate, typename Scorer, typename RelevanceAccumulator>
+void SearchServer::ScoreTerm(const ScoredTerm& term, const std::vector<bool>& excluded_slots, const DocumentPredicate& document_predicate, const Scorer& scorer,
+    RelevanceAccumulator&& accumulate) const {
+    for (const auto& [document_id, posting] : *term.postings) {
+        if ((excluded_slots.empty() || !excluded_slots[posting.slot]) && IsPostingAccepted(document_predicate, document_id, posting)) {
+            accumulate(posting.slot, scorer(term.weight, posting.term_freq, posting.term_count, documents_.GetLength(posting.slot)));
+        }
+    }
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate, typename Ranking>
+std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate, const Ranking& ranking, const QueryStatistics* statistics) const {
+    const auto scorer = ranking.MakeScorer(statistics ? statistics->GetCorpusStatistics() : GetCorpusStatistics());
+    const auto plan = PlanQuery(query, scorer, statistics);
+    if (plan.plus_terms.empty()) {
+        return {};
+    }
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, AdaptiveExecutionPolicy>) {
+        if (plan.is_parallel) {
+            return ExecuteQueryPlan(std::execution::par, plan, document_predicate, scorer);
+        }
+        return ExecuteQueryPlan(std::execution::seq, plan, document_predicate, scorer);
+    }
+    else {
+        return ExecuteQueryPlan(policy, plan, document_predicate, scorer);
+    }
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate, typename Scorer>
+std::vector<Document> SearchServer::ExecuteQueryPlan(ExecutionPolicy&& policy, const QueryPlan& plan, const DocumentPredicate& document_predicate, const Scorer& scorer) const {
+    std::vector<Document> matched_documents;
+    if (plan.has_phrases) {
+        // Only documents with every phrase word reach the positional check, and only matches are scored.
+        const auto& candidates = plan.phrase_candidates;
+        std::vector<char> is_phrase_match(candidates.size());
+        std::transform(policy, candidates.begin(), candidates.end(), is_phrase_match.begin(), [this, &plan](const std::pair<int, int>& candidate) {
+            std::vector<int> first_positions;
+            std::vector<int> positions;
+            return MatchesPhrases(candidate.second, plan.phrases, first_positions, positions);
+            });
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (!is_phrase_match[i]) {
+                continue;
+            }
+            const auto [document_id, slot] = candidates[i];
+            double relevance = 0.0;
+            bool is_accepted = true;
+            for (const ScoredTerm& term : plan.plus_terms) {
+                const auto it = term.postings->find(document_id);
+                if (it == term.postings->end()) {
+                    continue;
                 }
+                if (!IsPostingAccepted(document_predicate, document_id, it->second)) {
+                    is_accepted = false;
+                    break;
+                }
+                relevance += scorer(term.weight, it->second.term_freq, it->second.term_count, documents_.GetLength(slot));
             }
-        }
-    };
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), processing_for_plus_words);
-    auto processing_for_minus_words = [this, &document_to_relevance](std::string_view word) {
-        if (word_to_document_freqs_.count(word)) {
-            for (const auto [document_id, _] : word_to_document_freqs_.find(word)->second) {
-                document_to_relevance.Erase(document_id);
+            if (is_accepted) {
+                matched_documents.push_back({ document_id, relevance, documents_.GetRating(slot) });
             }
         }
-    };
-    std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), processing_for_minus_words);
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        return matched_documents;
+    }
+
+    std::map<int, double> slot_to_relevance;
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        for (const ScoredTerm& term : plan.plus_terms) {
+            ScoreTerm(term, plan.excluded_slots, document_predicate, scorer, [&slot_to_relevance](int slot, double relevance) {
+                slot_to_relevance[slot] += relevance;
+                });
+        }
+    }
+    else {
+        ConcurrentMap<int, double> concurrent_slot_to_relevance(std::thread::hardware_concurrency());
+        std::for_each(policy, plan.plus_terms.begin(), plan.plus_terms.end(), [this, &plan, &document_predicate, &scorer, &concurrent_slot_to_relevance](const ScoredTerm& term) {
+            ScoreTerm(term, plan.excluded_slots, document_predicate, scorer, [&concurrent_slot_to_relevance](int slot, double relevance) {
+                concurrent_slot_to_relevance[slot].ref_to_value += relevance;
+                });
+            });
+        slot_to_relevance = concurrent_slot_to_relevance.BuildOrdinaryMap();
+    }
+    for (const auto* postings : plan.rare_minus_postings) {
+        for (const auto& [_, posting] : *postings) {
+            slot_to_relevance.erase(posting.slot);
+        }
+    }
+    matched_documents.reserve(slot_to_relevance.size());
+    for (const auto [slot, relevance] : slot_to_relevance) {
+        matched_documents.push_back({ documents_.GetDocumentId(slot), relevance, documents_.GetRating(slot) });
     }
     return matched_documents;
 }
 
 template<typename ExecutionPolicy>
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const {
-    using namespace std::string_literals;
-    if (std::is_same_v<std::remove_reference_t<ExecutionPolicy&&>, const std::execution::sequenced_policy>) {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
         return MatchDocument(raw_query, document_id);
     }
-    if (!document_ids_.count(document_id)) {
-        throw std::out_of_range("Id of document out of range");
-    }
-    const auto query = ParseQuery(raw_query, false);
-    if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), [this, document_id](std::string_view word) {
-        auto it = word_to_document_freqs_.find(word);
-        return it != word_to_document_freqs_.end() && it->second.count(document_id);
-        })) {
-        return { {}, documents_.at(document_id).status };
+    else {
+        const int slot = documents_.FindSlot(document_id);
+        if (slot < 0) {
+            throw std::out_of_range("Id of document out of range");
+        }
+        const auto query = ParseQuery(raw_query, false);
+        const auto minus_term_ids = ResolveMinusTerms(query);
+        std::vector<std::string_view> matched_words;
+        if (std::any_of(policy, minus_term_ids.begin(), minus_term_ids.end(), [this, slot](int term_id) {
+            return HasDocumentTerm(slot, term_id);
+            })) {
+            return { matched_words, documents_.GetStatus(slot) };
+        }
+        if (!query.phrases.empty()) {
+            const auto phrases = PreparePhrases(query);
+            std::vector<int> first_positions;
+            std::vector<int> positions;
+            if (!phrases || !MatchesPhrases(slot, *phrases, first_positions, positions)) {
+                return { matched_words, documents_.GetStatus(slot) };
+            }
+        }
+        const auto plus_terms = ResolvePlusTerms(query);
+        std::vector<char> is_matched(plus_terms.size());
+        std::transform(policy, plus_terms.begin(), plus_terms.end(), is_matched.begin(), [this, slot](const ResolvedTerm& term) {
+            return HasDocumentTerm(slot, term.term_id);
+            });
+        for (size_t i = 0; i < plus_terms.size(); ++i) {
+            if (is_matched[i]) {
+                matched_words.push_back(term_words_[plus_terms[i].term_id]);
+            }
+        }
+        std::sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+        return { matched_words, documents_.GetStatus(slot) };
     }
-    std::vector<std::string_view> matched_words(query.plus_words.size());
-    auto it_for_resize = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [this, document_id](std::string_view word) {
-        auto it = word_to_document_freqs_.find(word);
-        return it != word_to_document_freqs_.end() && it->second.count(document_id);
-        });
-    matched_words.resize(it_for_resize - matched_words.begin());
-    std::set<std::string_view> unique_words(matched_words.begin(), matched_words.end());
-    return { std::vector<std::string_view>(unique_words.begin(), unique_words.end()), documents_.at(document_id).status };
 }
 
 template<typename ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
-    if (document_ids_.count(document_id)) {
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        auto& word_frequencies = document_id_to_word_frequencies_[document_id];
-        std::vector<std::map<std::string_view, double>::iterator> it_words;
-        it_words.reserve(word_frequencies.size());
-        for (auto it = word_frequencies.begin(); it != word_frequencies.end(); ++it) {
-            it_words.push_back(it);
-        }
-        std::for_each(policy, it_words.begin(), it_words.end(), [this, document_id](std::map<std::string_view, double>::iterator it_word) {
-            auto it = word_to_document_freqs_.find(it_word->first);
-            it->second.erase(document_id);
-            if (it->second.empty()) {
-                word_to_document_freqs_.erase(it);
-            }
-            });
-        document_id_to_word_frequencies_.erase(document_id);
+    RemoveDocuments(policy, std::vector<int>{ document_id });
+}
+
+template<typename ExecutionPolicy>
+void SearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    const auto removed_slots = documents_.RemoveDocuments(document_ids);
+    std::vector<std::pair<int, int>> term_documents;
+    for (const int slot : removed_slots) {
+        for (const TermWeight& term_weight : forward_index_[slot]) {
+            term_documents.push_back({ term_weight.term_id, documents_.GetDocumentId(slot) });
+        }
+    }
+    std::sort(policy, term_documents.begin(), term_documents.end());
+
+    // Each batch owns one term's postings, so batches can be erased concurrently.
+    std::vector<size_t> batch_starts;
+    for (size_t i = 0; i < term_documents.size(); ++i) {
+        if (i == 0 || term_documents[i].first != term_documents[i - 1].first) {
+            batch_starts.push_back(i);
+        }
+    }
+    std::for_each(policy, batch_starts.begin(), batch_starts.end(), [this, &term_documents](size_t batch_start) {
+        const int term_id = term_documents[batch_start].first;
+        auto& postings = term_postings_[term_id];
+        for (size_t i = batch_start; i < term_documents.size() && term_documents[i].first == term_id; ++i) {
+            postings.erase(term_documents[i].second);
+        }
+        });
+    std::for_each(policy, removed_slots.begin(), removed_slots.end(), [this](int slot) {
+        forward_index_[slot] = {};
+        positional_index_.RemoveDocument(slot);
+        });
+    for (const size_t batch_start : batch_starts) {
+        RemoveTermIfUnused(term_documents[batch_start].first);
     }
 }
\ No newline at end of file
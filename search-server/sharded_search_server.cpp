@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include "sharded_search_server.h"
+
+InProcessShardTransport::InProcessShardTransport(SearchServer search_server)
+    : search_server_(std::move(search_server)) {
+}
+
+void InProcessShardTransport::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    search_server_.AddDocument(document_id, document, status, ratings);
+}
+
+void InProcessShardTransport::RemoveDocument(int document_id) {
+    search_server_.RemoveDocument(document_id);
+}
+
+void InProcessShardTransport::RemoveDocuments(const std::vector<int>& document_ids) {
+    search_server_.RemoveDocuments(std::execution::par, document_ids);
+}
+
+int InProcessShardTransport::GetDocumentCount() const {
+    return search_server_.GetDocumentCount();
+}
+
+QueryStatistics InProcessShardTransport::CollectQueryStatistics(std::string_view raw_query) const {
+    return search_server_.CollectQueryStatistics(raw_query);
+}
+
+SearchPage InProcessShardTransport::FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, const QueryStatistics& statistics,
+    size_t page_size, const SearchCursor& after) const {
+    return search_server_.FindTopDocumentsPage(adaptive_execution, raw_query, DocumentStatusPredicate{ status }, statistics, page_size, after);
+}
+
+ShardedSearchServer::ShardedSearchServer(std::vector<std::unique_ptr<ShardTransport>> shards)
+    : shards_(std::move(shards)) {
+    using namespace std::literals;
+    if (shards_.empty()) {
+        throw std::invalid_argument("Sharded search server needs at least one shard"s);
+    }
+    shard_pool_ = std::make_unique<ThreadPool>(shards_.size() - 1);
+}
+
+template <typename Function>
+void ShardedSearchServer::ForEachShard(const Function& function) const {
+    std::vector<std::future<void>> futures;
+    futures.reserve(shards_.size() - 1);
+    for (size_t i = 1; i < shards_.size(); ++i) {
+        futures.push_back(shard_pool_->Submit([&function, i] {
+            function(i);
+            }));
+    }
+    // A shard may throw on an invalid query, but the other tasks still refer to
+    // the caller's arguments, so every one has to finish before the error propagates.
+    std::exception_ptr error;
+    try {
+        function(0);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& future : futures) {
+        try {
+            future.get();
+        }
+        catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    shards_[GetShardIndex(document_id)]->AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    shards_[GetShardIndex(document_id)]->RemoveDocument(document_id);
+}
+
+void ShardedSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    std::vector<std::vector<int>> shard_document_ids(shards_.size());
+    for (const int document_id : document_ids) {
+        shard_document_ids[GetShardIndex(document_id)].push_back(document_id);
+    }
+    ForEachShard([this, &shard_document_ids](size_t i) {
+        if (!shard_document_ids[i].empty()) {
+            shards_[i]->RemoveDocuments(shard_document_ids[i]);
+        }
+        });
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const auto& shard : shards_) {
+        document_count += shard->GetDocumentCount();
+    }
+    return document_count;
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocumentsPage(raw_query, status, MAX_RESULT_DOCUMENT_COUNT).documents;
+}
+
+SearchPage ShardedSearchServer::FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, size_t page_size, const SearchCursor& after) const {
+    std::vector<QueryStatistics> shard_statistics(shards_.size());
+    ForEachShard([this, raw_query, &shard_statistics](size_t i) {
+        shard_statistics[i] = shards_[i]->CollectQueryStatistics(raw_query);
+        });
+    QueryStatistics statistics;
+    for (const QueryStatistics& one_shard_statistics : shard_statistics) {
+        statistics.Merge(one_shard_statistics);
+    }
+
+    std::vector<SearchPage> pages(shards_.size());
+    ForEachShard([this, raw_query, status, &statistics, page_size, &after, &pages](size_t i) {
+        pages[i] = shards_[i]->FindTopDocumentsPage(raw_query, status, statistics, page_size, after);
+        });
+    return SearchServer::MergePages(pages, page_size);
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    const uint64_t hash = static_cast<uint32_t>(document_id) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>((hash >> 32) % shards_.size());
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "query_statistics.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+class ShardTransport {
+public:
+    virtual ~ShardTransport() = default;
+
+    virtual void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) = 0;
+
+    virtual void RemoveDocument(int document_id) = 0;
+
+    virtual void RemoveDocuments(const std::vector<int>& document_ids) = 0;
+
+    virtual int GetDocumentCount() const = 0;
+
+    virtual QueryStatistics CollectQueryStatistics(std::string_view raw_query) const = 0;
+
+    virtual SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, const QueryStatistics& statistics,
+        size_t page_size, const SearchCursor& after) const = 0;
+};
+
+class InProcessShardTransport : public ShardTransport {
+public:
+    explicit InProcessShardTransport(SearchServer search_server);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) override;
+
+    void RemoveDocument(int document_id) override;
+
+    void RemoveDocuments(const std::vector<int>& document_ids) override;
+
+    int GetDocumentCount() const override;
+
+    QueryStatistics CollectQueryStatistics(std::string_view raw_query) const override;
+
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, const QueryStatistics& statistics,
+        size_t page_size, const SearchCursor& after) const override;
+
+private:
+    SearchServer search_server_;
+};
+
+class ShardedSearchServer {
+public:
+    explicit ShardedSearchServer(std::vector<std::unique_ptr<ShardTransport>> shards);
+
+    template <typename StringContainer>
+    static ShardedSearchServer MakeInProcess(const StringContainer& stop_words, size_t shard_count);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    int GetDocumentCount() const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, size_t page_size, const SearchCursor& after = SearchCursor()) const;
+
+    size_t GetShardIndex(int document_id) const;
+
+private:
+    std::vector<std::unique_ptr<ShardTransport>> shards_;
+    // Shard 0 runs on the calling thread, so the pool has one thread less than there are shards.
+    std::unique_ptr<ThreadPool> shard_pool_;
+
+    template <typename Function>
+    void ForEachShard(const Function& function) const;
+};
+
+template <typename StringContainer>
+ShardedSearchServer ShardedSearchServer::MakeInProcess(const StringContainer& stop_words, size_t shard_count) {
+    std::vector<std::unique_ptr<ShardTransport>> shards;
+    shards.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards.push_back(std::make_unique<InProcessShardTransport>(SearchServer(stop_words)));
+    }
+    return ShardedSearchServer(std::move(shards));
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
 #include "string_processing.h"
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view text) {
@@ -12,4 +13,39 @@ std::vector<std::string_view> SplitIntoWordsView(std::string_view text) {
         text.remove_prefix(std::min(text.find_first_not_of(' '), text.size()));
     }
     return result;
+}
+
+void DecodeUtf8(std::string_view text, std::u32string& code_points) {
+    code_points.clear();
+    for (size_t i = 0; i < text.size();) {
+        const uint8_t lead = static_cast<uint8_t>(text[i]);
+        size_t length = 1;
+        char32_t code_point = lead;
+        char32_t min_code_point = 0;
+        if (lead >= 0xC2 && lead < 0xE0) {
+            length = 2;
+            code_point = lead & 0x1F;
+            min_code_point = 0x80;
+        }
+        else if (lead >= 0xE0 && lead < 0xF0) {
+            length = 3;
+            code_point = lead & 0x0F;
+            min_code_point = 0x800;
+        }
+        else if (lead >= 0xF0 && lead < 0xF5) {
+            length = 4;
+            code_point = lead & 0x07;
+            min_code_point = 0x10000;
+        }
+        size_t j = 1;
+        for (; j < length && i + j < text.size() && (static_cast<uint8_t>(text[i + j]) & 0xC0) == 0x80; ++j) {
+            code_point = code_point << 6 | (static_cast<uint8_t>(text[i + j]) & 0x3F);
+        }
+        if (j < length || code_point < min_code_point || code_point > 0x10FFFF) {
+            code_point = lead;
+            length = 1;
+        }
+        code_points.push_back(code_point);
+        i += length;
+    }
 }
\ No newline at end of file
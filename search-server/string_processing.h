@@ -7,6 +7,9 @@
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view text);
 
+// Replaces code_points with the characters of a UTF-8 text; a byte that does not start a valid sequence is taken as one character.
+void DecodeUtf8(std::string_view text, std::u32string& code_points);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
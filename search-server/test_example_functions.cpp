@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include "test_example_functions.h"
 
@@ -29,12 +31,41 @@ void MatchDocuments(const SearchServer& search_server, const std::string& query)
     using namespace std::literals;
     try {
         std::cout << "Matching documents on request: "s << query << std::endl;
+        const auto match_query = search_server.PrepareMatchQuery(query);
+        std::vector<std::string_view> words;
         for (int document_id : search_server) {
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
+            const DocumentStatus status = search_server.MatchDocument(match_query, document_id, words);
             PrintMatchDocumentResult(document_id, words, status);
         }
     }
     catch (const std::invalid_argument& e) {
         std::cout << "Error in matching documents to a request "s << query << ": "s << e.what() << std::endl;
     }
+}
+
+void TestFuzzySearchOnCyrillicWords() {
+    using namespace std::literals;
+    IndexOptions options;
+    options.index_fuzzy_terms = true;
+    SearchServer search_server(""s, options);
+    search_server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "пушистый котики пушистый хвост"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "кол"s, DocumentStatus::ACTUAL, { 1 });
+    const auto find_ids = [&search_server](const std::string& raw_query) {
+        std::vector<int> ids;
+        for (const Document& document : search_server.FindTopDocuments(raw_query)) {
+            ids.push_back(document.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    if (find_ids("котик~"s) != std::vector<int>{ 2 } || find_ids("кот~"s) != std::vector<int>{ 1, 3 }
+        || find_ids("кот~ -ошейник~"s) != std::vector<int>{ 3 }) {
+        throw std::logic_error("Fuzzy search counts UTF-8 bytes instead of characters"s);
+    }
+    // "кол" is one substitution away from "кот" and is the only word of document 3.
+    const auto documents = search_server.FindTopDocuments("кот~"s);
+    if (documents.empty() || documents[0].id != 3 || std::abs(documents[0].relevance - FUZZY_DISTANCE_PENALTY * std::log(3.0)) > 1e-6) {
+        throw std::logic_error("A one-letter typo must be penalized once"s);
+    }
 }
\ No newline at end of file
@@ -10,4 +10,7 @@ void AddDocument(SearchServer& search_server, int document_id, const std::string
 
 void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query);
 
-void MatchDocuments(const SearchServer& search_server, const std::string& query);
\ No newline at end of file
+void MatchDocuments(const SearchServer& search_server, const std::string& query);
+
+// Checks that typo distances on UTF-8 words are counted in characters; throws std::logic_error on failure.
+void TestFuzzySearchOnCyrillicWords();
\ No newline at end of file
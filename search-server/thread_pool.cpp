@@ -0,0 +1,42 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t thread_count, std::function<void()> thread_init) {
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, thread_init] {
+            Work(thread_init);
+            });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopping_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Work(const std::function<void()>& thread_init) {
+    if (thread_init) {
+        thread_init();
+    }
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            condition_.wait(lock, [this] {
+                return is_stopping_ || !tasks_.empty();
+                });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
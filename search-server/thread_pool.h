@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Threads that live as long as the pool and run submitted tasks in submission order.
+class ThreadPool {
+public:
+    // Each thread calls thread_init once before taking tasks, e.g. to pin itself to CPUs.
+    explicit ThreadPool(size_t thread_count, std::function<void()> thread_init = {});
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs the tasks already submitted, then joins the threads.
+    ~ThreadPool();
+
+    size_t GetThreadCount() const {
+        return threads_.size();
+    }
+
+    // An exception thrown by the task is rethrown by the future's get().
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> Submit(Function function);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    bool is_stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    void Work(const std::function<void()>& thread_init);
+};
+
+template <typename Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::Submit(Function function) {
+    // std::function needs a copyable target and packaged_task is move-only.
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    auto future = task->get_future();
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back([task] {
+            (*task)();
+            });
+    }
+    condition_.notify_one();
+    return future;
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include "string_processing.h"
+#include "trigram_index.h"
+
+namespace {
+
+const size_t MAX_LENGTH_BUCKET = 255;
+
+// Stands for the word boundary; control characters never occur in indexed words.
+const char32_t PADDING_CHAR = 1;
+
+// A trigram packs three 21-bit code points, the first one in the low bits.
+uint64_t MakeTrigram(char32_t first, char32_t second, char32_t third) {
+    return uint64_t{ first } | uint64_t{ second } << 21 | uint64_t{ third } << 42;
+}
+
+const uint64_t LEADING_PADDING_MASK = MakeTrigram(0x1FFFFF, 0x1FFFFF, 0);
+const uint64_t LEADING_PADDING = MakeTrigram(PADDING_CHAR, PADDING_CHAR, 0);
+
+size_t GetLengthBucket(size_t length) {
+    return std::min(length, MAX_LENGTH_BUCKET);
+}
+
+}
+
+class TrigramIndex::EditDistanceMatcher {
+public:
+    explicit EditDistanceMatcher(std::u32string_view word)
+        : word_(word) {
+        if (word_.size() > MAX_BIT_PARALLEL_SIZE) {
+            return;
+        }
+        for (size_t i = 0; i < word_.size(); ++i) {
+            const uint64_t bit = uint64_t{ 1 } << i;
+            if (word_[i] < ascii_masks_.size()) {
+                ascii_masks_[word_[i]] |= bit;
+            }
+            else {
+                other_masks_.push_back({ word_[i], bit });
+            }
+        }
+        std::sort(other_masks_.begin(), other_masks_.end());
+        size_t unique_count = 0;
+        for (const auto& [c, bit] : other_masks_) {
+            if (unique_count > 0 && other_masks_[unique_count - 1].first == c) {
+                other_masks_[unique_count - 1].second |= bit;
+            }
+            else {
+                other_masks_[unique_count++] = { c, bit };
+            }
+        }
+        other_masks_.resize(unique_count);
+    }
+
+    // Returns max_distance + 1 when the distance is larger.
+    int ComputeDistance(std::string_view other_text, int max_distance) {
+        DecodeUtf8(other_text, other_);
+        const std::u32string_view other = other_;
+        const int size = static_cast<int>(word_.size());
+        const int other_size = static_cast<int>(other.size());
+        if (std::abs(size - other_size) > max_distance) {
+            return max_distance + 1;
+        }
+        if (size == 0) {
+            return other_size;
+        }
+        if (word_.size() <= MAX_BIT_PARALLEL_SIZE) {
+            return ComputeBitParallel(other, max_distance);
+        }
+        return ComputeRows(other, max_distance);
+    }
+
+private:
+    static const size_t MAX_BIT_PARALLEL_SIZE = 64;
+
+    std::u32string_view word_;
+    std::array<uint64_t, 128> ascii_masks_ = {};
+    // Sorted by character.
+    std::vector<std::pair<char32_t, uint64_t>> other_masks_;
+    std::u32string other_;
+    std::vector<int> previous_;
+    std::vector<int> current_;
+
+    // Myers' algorithm in Hyyro's form: one DP column per character of other, kept as
+    // bit vectors of +1/-1 vertical deltas; distance tracks the cell in the last row.
+    uint64_t GetCharMask(char32_t c) const {
+        if (c < ascii_masks_.size()) {
+            return ascii_masks_[c];
+        }
+        const auto it = std::lower_bound(other_masks_.begin(), other_masks_.end(), c, [](const auto& entry, char32_t value) {
+            return entry.first < value;
+            });
+        return it != other_masks_.end() && it->first == c ? it->second : 0;
+    }
+
+    int ComputeBitParallel(std::u32string_view other, int max_distance) const {
+        const uint64_t last_bit = uint64_t{ 1 } << (word_.size() - 1);
+        uint64_t positive = ~uint64_t{ 0 };
+        uint64_t negative = 0;
+        int distance = static_cast<int>(word_.size());
+        for (size_t j = 0; j < other.size(); ++j) {
+            const uint64_t equal = GetCharMask(other[j]);
+            const uint64_t vertical = equal | negative;
+            const uint64_t horizontal = (((equal & positive) + positive) ^ positive) | equal;
+            uint64_t horizontal_positive = negative | ~(horizontal | positive);
+            uint64_t horizontal_negative = positive & horizontal;
+            if (horizontal_positive & last_bit) {
+                ++distance;
+            }
+            else if (horizontal_negative & last_bit) {
+                --distance;
+            }
+            // The first row grows by one per column.
+            horizontal_positive = horizontal_positive << 1 | 1;
+            horizontal_negative <<= 1;
+            positive = horizontal_negative | ~(vertical | horizontal_positive);
+            negative = horizontal_positive & vertical;
+            if (distance - static_cast<int>(other.size() - j - 1) > max_distance) {
+                return max_distance + 1;
+            }
+        }
+        return std::min(distance, max_distance + 1);
+    }
+
+    int ComputeRows(std::u32string_view other, int max_distance) {
+        const int size = static_cast<int>(word_.size());
+        const int other_size = static_cast<int>(other.size());
+        previous_.resize(other_size + 1);
+        current_.resize(other_size + 1);
+        for (int j = 0; j <= other_size; ++j) {
+            previous_[j] = j;
+        }
+        for (int i = 1; i <= size; ++i) {
+            current_[0] = i;
+            int row_min = current_[0];
+            for (int j = 1; j <= other_size; ++j) {
+                const int substitution = previous_[j - 1] + (word_[i - 1] == other[j - 1] ? 0 : 1);
+                current_[j] = std::min({ previous_[j] + 1, current_[j - 1] + 1, substitution });
+                row_min = std::min(row_min, current_[j]);
+            }
+            if (row_min > max_distance) {
+                return max_distance + 1;
+            }
+            std::swap(previous_, current_);
+        }
+        return std::min(previous_[other_size], max_distance + 1);
+    }
+};
+
+void TrigramIndex::AddTerm(int term_id, std::string_view word) {
+    std::u32string chars;
+    DecodeUtf8(word, chars);
+    const size_t length_bucket = GetLengthBucket(chars.size());
+    if (length_trigram_term_ids_.size() <= length_bucket) {
+        length_trigram_term_ids_.resize(length_bucket + 1);
+    }
+    for (const uint64_t trigram : ExtractTrigrams(chars)) {
+        auto& term_ids = length_trigram_term_ids_[length_bucket][trigram];
+        term_ids.insert(std::lower_bound(term_ids.begin(), term_ids.end(), term_id), term_id);
+    }
+}
+
+void TrigramIndex::RemoveTerm(int term_id, std::string_view word) {
+    std::u32string chars;
+    DecodeUtf8(word, chars);
+    const size_t length_bucket = GetLengthBucket(chars.size());
+    if (length_trigram_term_ids_.size() <= length_bucket) {
+        return;
+    }
+    auto& trigram_term_ids = length_trigram_term_ids_[length_bucket];
+    for (const uint64_t trigram : ExtractTrigrams(chars)) {
+        const auto it = trigram_term_ids.find(trigram);
+        if (it == trigram_term_ids.end()) {
+            continue;
+        }
+        auto& term_ids = it->second;
+        const auto term_it = std::lower_bound(term_ids.begin(), term_ids.end(), term_id);
+        if (term_it != term_ids.end() && *term_it == term_id) {
+            term_ids.erase(term_it);
+        }
+        if (term_ids.empty()) {
+            trigram_term_ids.erase(it);
+        }
+    }
+}
+
+std::vector<std::pair<int, int>> TrigramIndex::FindTerms(std::string_view word, int max_distance,
+    const std::vector<std::string_view>& term_words, size_t max_terms) const {
+    std::u32string chars;
+    DecodeUtf8(word, chars);
+    const auto trigrams = ExtractTrigrams(chars);
+    std::vector<std::pair<int, int>> result;
+    EditDistanceMatcher matcher(chars);
+    const size_t min_length = chars.size() > static_cast<size_t>(max_distance) ? chars.size() - max_distance : 0;
+    const size_t end_length_bucket = std::min(GetLengthBucket(chars.size() + max_distance) + 1, length_trigram_term_ids_.size());
+    for (size_t length_bucket = GetLengthBucket(min_length); length_bucket < end_length_bucket; ++length_bucket) {
+        FindTermsOfLength(chars.size(), trigrams, length_bucket, max_distance, term_words, matcher, result);
+    }
+    if (result.size() > max_terms) {
+        std::partial_sort(result.begin(), result.begin() + max_terms, result.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+            });
+        result.resize(max_terms);
+    }
+    return result;
+}
+
+int TrigramIndex::ComputeEditDistance(std::string_view lhs, std::string_view rhs, int max_distance) {
+    std::u32string lhs_chars;
+    DecodeUtf8(lhs, lhs_chars);
+    return EditDistanceMatcher(lhs_chars).ComputeDistance(rhs, max_distance);
+}
+
+void TrigramIndex::FindTermsOfLength(size_t word_size, const std::vector<uint64_t>& trigrams, size_t length_bucket, int max_distance,
+    const std::vector<std::string_view>& term_words, EditDistanceMatcher& matcher, std::vector<std::pair<int, int>>& result) const {
+    static const std::vector<int> no_term_ids;
+    const auto& length_term_ids = length_trigram_term_ids_[length_bucket];
+    std::vector<const std::vector<int>*> trigram_term_ids;
+    trigram_term_ids.reserve(trigrams.size());
+    for (const uint64_t trigram : trigrams) {
+        const auto it = length_term_ids.find(trigram);
+        trigram_term_ids.push_back(it != length_term_ids.end() ? &it->second : &no_term_ids);
+    }
+    std::sort(trigram_term_ids.begin(), trigram_term_ids.end(), [](const std::vector<int>* lhs, const std::vector<int>* rhs) {
+        return lhs->size() < rhs->size();
+        });
+
+    // One edit destroys at most three trigrams, so a match shares all but 3 * max_distance of them
+    // and appears in at least one of the rarest candidate_list_count lists. When the word has no
+    // repeated trigrams, the surviving trigrams of a term map to distinct ones of the word, so the
+    // bound also holds for the term's own length + 2 trigrams.
+    size_t trigram_count = trigrams.size();
+    if (trigrams.size() == word_size + 2 && length_bucket < MAX_LENGTH_BUCKET) {
+        trigram_count = std::max<size_t>(trigram_count, length_bucket + 2);
+    }
+    const size_t destroyed_count = static_cast<size_t>(3 * max_distance);
+    if (trigram_count <= destroyed_count) {
+        // Short enough for a match to share no trigram: every term of this length is a candidate.
+        // Each term has exactly one trigram that starts with two padding characters.
+        std::vector<int> term_ids;
+        for (const auto& [trigram, trigram_ids] : length_term_ids) {
+            if ((trigram & LEADING_PADDING_MASK) == LEADING_PADDING) {
+                term_ids.insert(term_ids.end(), trigram_ids.begin(), trigram_ids.end());
+            }
+        }
+        for (const int term_id : term_ids) {
+            const int distance = matcher.ComputeDistance(term_words[term_id], max_distance);
+            if (distance <= max_distance) {
+                result.push_back({ term_id, distance });
+            }
+        }
+        return;
+    }
+    const size_t min_shared_count = trigram_count - destroyed_count;
+    const size_t candidate_list_count = trigrams.size() - min_shared_count + 1;
+
+    std::vector<int> candidates;
+    for (size_t i = 0; i < candidate_list_count; ++i) {
+        const auto middle = candidates.insert(candidates.end(), trigram_term_ids[i]->begin(), trigram_term_ids[i]->end());
+        std::inplace_merge(candidates.begin(), middle, candidates.end());
+    }
+
+    // Candidates ascend, so each longer list is searched from where the previous lookup stopped.
+    std::vector<std::vector<int>::const_iterator> list_positions;
+    list_positions.reserve(trigrams.size() - candidate_list_count);
+    for (size_t i = candidate_list_count; i < trigrams.size(); ++i) {
+        list_positions.push_back(trigram_term_ids[i]->begin());
+    }
+
+    for (size_t begin = 0, end = 0; begin < candidates.size(); begin = end) {
+        const int term_id = candidates[begin];
+        while (end < candidates.size() && candidates[end] == term_id) {
+            ++end;
+        }
+        size_t shared_count = end - begin;
+        for (size_t i = 0; i < list_positions.size() && shared_count < min_shared_count; ++i) {
+            if (shared_count + (list_positions.size() - i) < min_shared_count) {
+                break;
+            }
+            const std::vector<int>& term_ids = *trigram_term_ids[candidate_list_count + i];
+            list_positions[i] = std::lower_bound(list_positions[i], term_ids.end(), term_id);
+            if (list_positions[i] != term_ids.end() && *list_positions[i] == term_id) {
+                ++shared_count;
+            }
+        }
+        if (shared_count < min_shared_count) {
+            continue;
+        }
+        const int distance = matcher.ComputeDistance(term_words[term_id], max_distance);
+        if (distance <= max_distance) {
+            result.push_back({ term_id, distance });
+        }
+    }
+}
+
+std::vector<uint64_t> TrigramIndex::ExtractTrigrams(std::u32string_view word) {
+    std::u32string padded;
+    padded.reserve(word.size() + 4);
+    padded.append(2, PADDING_CHAR);
+    padded += word;
+    padded.append(2, PADDING_CHAR);
+    std::vector<uint64_t> trigrams;
+    trigrams.reserve(padded.size() - 2);
+    for (size_t i = 0; i + 2 < padded.size(); ++i) {
+        trigrams.push_back(MakeTrigram(padded[i], padded[i + 1], padded[i + 2]));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class TrigramIndex {
+public:
+    void AddTerm(int term_id, std::string_view word);
+
+    void RemoveTerm(int term_id, std::string_view word);
+
+    // Returns (term id, edit distance) for indexed terms within max_distance of word.
+    // Trigrams, lengths and distances are counted in characters of the UTF-8 text.
+    std::vector<std::pair<int, int>> FindTerms(std::string_view word, int max_distance,
+        const std::vector<std::string_view>& term_words, size_t max_terms) const;
+
+    static int ComputeEditDistance(std::string_view lhs, std::string_view rhs, int max_distance);
+
+private:
+    // Edit distance from one word to many candidates without allocating per candidate.
+    class EditDistanceMatcher;
+
+    // Indexed by term length, then keyed by trigram, so a lookup only reads terms of a matching length.
+    std::vector<std::unordered_map<uint64_t, std::vector<int>>> length_trigram_term_ids_;
+
+    static std::vector<uint64_t> ExtractTrigrams(std::u32string_view word);
+
+    void FindTermsOfLength(size_t word_size, const std::vector<uint64_t>& trigrams, size_t length_bucket, int max_distance,
+        const std::vector<std::string_view>& term_words, EditDistanceMatcher& matcher, std::vector<std::pair<int, int>>& result) const;
+};
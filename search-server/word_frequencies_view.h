@@ -0,0 +1,77 @@
+#pragma once
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct TermWeight {
+    int term_id;
+    double weight;
+};
+
+class WordFrequenciesView {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(std::vector<TermWeight>::const_iterator it, const std::vector<std::string_view>* term_words)
+            : it_(it)
+            , term_words_(term_words) {
+        }
+
+        value_type operator*() const {
+            return { (*term_words_)[it_->term_id], it_->weight };
+        }
+
+        Iterator& operator++() {
+            ++it_;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return it_ == other.it_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return it_ != other.it_;
+        }
+
+    private:
+        std::vector<TermWeight>::const_iterator it_;
+        const std::vector<std::string_view>* term_words_;
+    };
+
+    WordFrequenciesView(const std::vector<TermWeight>& term_weights, const std::vector<std::string_view>& term_words)
+        : term_weights_(&term_weights)
+        , term_words_(&term_words) {
+    }
+
+    Iterator begin() const {
+        return Iterator(term_weights_->begin(), term_words_);
+    }
+
+    Iterator end() const {
+        return Iterator(term_weights_->end(), term_words_);
+    }
+
+    size_t size() const {
+        return term_weights_->size();
+    }
+
+    bool empty() const {
+        return term_weights_->empty();
+    }
+
+    const std::vector<TermWeight>& GetTermWeights() const {
+        return *term_weights_;
+    }
+
+private:
+    const std::vector<TermWeight>* term_weights_;
+    const std::vector<std::string_view>* term_words_;
+};